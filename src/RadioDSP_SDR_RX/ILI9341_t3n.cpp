@@ -903,6 +903,91 @@ bool ILI9341_t3n::updateScreenAsync(
 #endif
 }
 
+//=======================================================================
+// updateScreenAsyncRows - one shot async update of the rows y0..y1.
+// Full width rows are contiguous in the frame buffer, so the DMA sends
+// them in one pass (split in up to 3 TCDs as the full frame does) with no
+// per row setup. The changed bands of the rows are cleared.
+// Only the T4 does it with DMA, the others update the whole frame.
+//=======================================================================
+bool ILI9341_t3n::updateScreenAsyncRows(int16_t y0, int16_t y1) {
+#ifdef ENABLE_ILI9341_FRAMEBUFFER
+  if (!_use_fbtft)
+    return false;
+  if (y0 < 0)
+    y0 = 0;
+  if (y1 >= _height)
+    y1 = _height - 1;
+  if (y0 > y1)
+    return false;
+
+#if defined(__IMXRT1052__) || defined(__IMXRT1062__) // Teensy 4.x
+  initDMASettings();
+  if (_dma_state & ILI9341_DMA_ACTIVE)
+    return false;
+
+  // the bands go now, later drawing marks them again
+  _changed_bands &= ~((2u << (y1 >> ILI9341_CHANGED_BAND_SHIFT)) -
+                      (1u << (y0 >> ILI9341_CHANGED_BAND_SHIFT)));
+
+  uint16_t *pfb = &_pfbtft[y0 * _width];
+  uint32_t count_words = (uint32_t)(y1 - y0 + 1) * _width;
+  if ((uint32_t)pfb >= 0x20200000u)
+    arm_dcache_flush(pfb, count_words * 2);
+
+  // chain of TCDs of at most COUNT_WORDS_WRITE words, the last one stops
+  uint8_t ns = 0;
+  while (count_words) {
+    uint32_t cw = (count_words > COUNT_WORDS_WRITE) ? COUNT_WORDS_WRITE
+                                                     : count_words;
+    DMASetting &ds = _dmasettings_rows[ns];
+    ds.sourceBuffer(pfb, cw * 2);
+    ds.destination(_pimxrt_spi->TDR);
+    ds.TCD->ATTR_DST = 1;
+    ds.TCD->CSR = 0;
+    pfb += cw;
+    count_words -= cw;
+    if (count_words)
+      ds.replaceSettingsOnCompletion(_dmasettings_rows[ns + 1]);
+    else {
+      ds.interruptAtCompletion();
+      ds.disableOnCompletion();
+    }
+    ns++;
+  }
+
+  beginSPITransaction(_SPI_CLOCK);
+  setAddr(0, y0, _width - 1, y1);
+  writecommand_last(ILI9341_RAMWR);
+
+  // Update TCR to 16 bit mode, as updateScreenAsync
+  _spi_fcr_save = _pimxrt_spi->FCR;
+  _pimxrt_spi->FCR = 0;
+  maybeUpdateTCR(_tcr_dc_not_assert | LPSPI_TCR_FRAMESZ(15) |
+                 LPSPI_TCR_RXMSK);
+  _pimxrt_spi->DER = LPSPI_DER_TDDE;
+  _pimxrt_spi->SR = 0x3f00;
+
+  _dmatx.triggerAtHardwareEvent(_spi_hardware->tx_dma_channel);
+  _dmatx = _dmasettings_rows[0];
+  _dmatx.begin(false);
+  _dmatx.enable();
+
+  _dmaActiveDisplay[_spi_num] = this;
+  _dma_state &= ~ILI9341_DMA_CONT;
+  _dma_state |= ILI9341_DMA_ACTIVE;
+  return true;
+#else
+  if (!updateScreenAsync(false))
+    return false;
+  clearChangedRange();
+  return true;
+#endif
+#else
+  return false;
+#endif
+}
+
 void ILI9341_t3n::endUpdateAsync() {
 // make sure it is on
 #ifdef ENABLE_ILI9341_FRAMEBUFFER
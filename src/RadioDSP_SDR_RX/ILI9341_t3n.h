@@ -90,6 +90,10 @@
 #endif
 #endif
 
+// The changed rows are also tracked in bands of 1 << ILI9341_CHANGED_BAND_SHIFT
+// rows, one bit each, so an async update can send only the bands touched.
+#define ILI9341_CHANGED_BAND_SHIFT 4
+
 // Allow way to override using SPI
 
 #ifdef __cplusplus
@@ -499,6 +503,13 @@ public:
   uint32_t frameCount() { return _dma_frame_count; }
   uint16_t subFrameCount() { return _dma_sub_frame_count; }
   boolean asyncUpdateActive(void) { return (_dma_state & ILI9341_DMA_ACTIVE); }
+  // updateScreenAsyncRows - one shot async update of the full width rows
+  //				y0..y1, clears their changed bands
+  bool updateScreenAsyncRows(int16_t y0, int16_t y1);
+  uint32_t changedBands() { return _changed_bands; }
+  void markChangedArea(int16_t x, int16_t y, int16_t w, int16_t h) {
+    updateChangedRange(x, y, w, h);
+  }
   void initDMASettings(void);
   void setFrameCompleteCB(void (*pcb)(), bool fCallAlsoHalfDone = false);
 #else
@@ -506,6 +517,9 @@ public:
   uint16_t subFrameCount() { return 0; }
   uint16_t *getFrameBuffer() { return NULL; }
   boolean asyncUpdateActive(void) { return false; }
+  bool updateScreenAsyncRows(int16_t y0, int16_t y1) { return false; }
+  uint32_t changedBands() { return 0; }
+  void markChangedArea(int16_t x, int16_t y, int16_t w, int16_t h) {}
 #endif
 protected:
   SPIClass *_pspi = nullptr;
@@ -630,6 +644,7 @@ protected:
   uint8_t _use_fbtft;             // Are we in frame buffer mode?
   uint16_t *_we_allocated_buffer; // We allocated the buffer;
   int16_t _changed_min_x, _changed_max_x, _changed_min_y, _changed_max_y;
+  uint32_t _changed_bands = 0; // changed rows, see ILI9341_CHANGED_BAND_SHIFT
   bool _updateChangedAreasOnly = false; // current default off,
   void (*_frame_complete_callback)() = nullptr;
   bool _frame_callback_on_HalfDone = false;
@@ -658,6 +673,7 @@ protected:
 
   static const uint32_t _count_pixels = ILI9341_TFTWIDTH * ILI9341_TFTHEIGHT;
   DMASetting _dmasettings[3];
+  DMASetting _dmasettings_rows[3]; // chain used by updateScreenAsyncRows
   DMAChannel _dmatx;
   volatile uint32_t _dma_pixel_index = 0;
   uint16_t _dma_buffer_size; // the actual size we are using <= DMA_BUFFER_SIZE;
@@ -952,12 +968,26 @@ protected:
   void clearChangedRange() {
     _changed_min_x = 0x7fff;
     _changed_max_x = -1;
-    _changed_min_x = 0x7fff;
+    _changed_min_y = 0x7fff;
     _changed_max_y = -1;
+    _changed_bands = 0;
+  }
+
+  // mark the bands of rows y0..y1, the text code can pass rows off screen
+  void updateChangedBands(int16_t y0, int16_t y1)
+      __attribute__((always_inline)) {
+    if (y0 < 0)
+      y0 = 0;
+    if (y1 >= _height)
+      y1 = _height - 1;
+    if (y0 <= y1)
+      _changed_bands |= (2u << (y1 >> ILI9341_CHANGED_BAND_SHIFT)) -
+                        (1u << (y0 >> ILI9341_CHANGED_BAND_SHIFT));
   }
 
   void updateChangedRange(int16_t x, int16_t y, int16_t w, int16_t h)
       __attribute__((always_inline)) {
+    updateChangedBands(y, y + h - 1);
     if (x < _changed_min_x)
       _changed_min_x = x;
     if (y < _changed_min_y)
@@ -972,6 +1002,7 @@ protected:
 
   // could combine with above, but avoids the +-...
   void updateChangedRange(int16_t x, int16_t y) __attribute__((always_inline)) {
+    updateChangedBands(y, y);
     if (x < _changed_min_x)
       _changed_min_x = x;
     if (y < _changed_min_y)
@@ -0,0 +1,326 @@
+/**
+  ******************************************************************************
+  * @file    RDSP_cat.h
+  * @author  Giuseppe Callipo - IK8YFW - ik8yfw@libero.it
+  * @version V1.0.0
+  * @date    19-10-2026
+  * @brief   CAT control on the USB serial, Kenwood TS-2000 / K3 subset
+  *
+  ******************************************************************************
+  *
+  * Commands end with ';', the answers have the same form, "?;" for an
+  * unknown or malformed command:
+  *
+  *   FA;  FAnnnnnnnnnnn;   VFO frequency, 11 digits in Hz
+  *   MD;  MDn;             mode: 1 LSB, 2 USB, 3 CW, 5 AM, 6 FSK (RTTY),
+  *                         7 CW-R and 9 FSK-R are taken as CW and RTTY
+  *   FW;  FWnnnn;          filter width in Hz, set takes the narrowest
+  *                         filter not below the request
+  *   IF;                   status, TS-2000 format
+  *   SM;  SM0;             S-meter, 0000-0030 (S9 = 0015, S9+60 = 0030)
+  *   PB;  PBllllhhhh;      PBT low and high cut in Hz (custom)
+  *   NR;  NRn;             noise reduction 0 off, 1 notch, 2-5 DNR 1-4,
+  *                         6-7 fixed point notch / DNR in bypass (custom)
+  *   DB;  DBn;             debug: statistics page n (0 if omitted) as text
+  *                         lines, closed by DBn; (custom, see
+  *                         Telemetry_Report in the sketch)
+  *
+  * The parser is fed a character at a time into a fixed buffer, at most
+  * CAT_MAX_BYTES per call so a pass of the loop stays short; nothing is
+  * allocated and nothing waits: an answer that does not fit in the USB
+  * buffer is dropped and counted. The debug pages are longer than the
+  * USB buffer: they are written in catReport and sent a piece per poll,
+  * the answers that come meanwhile queue behind them.
+  *
+  * The port is the Stream given to initCat(), USB Serial on the radio.
+  * On the host the radio side (vfoFreq, tuningMode() ...) is defined by
+  * the test, which replays sessions through a stub of the port.
+  *
+   */
+
+#ifndef RDSP_CAT_H_INCLUDED
+#define RDSP_CAT_H_INCLUDED
+
+#ifdef ARDUINO
+#include "RDSP_general_includes.h"
+#include "RDSP_convolutional.h"
+#include "RDSP_display.h"
+#include "RDSP_controls.h"
+#endif
+
+#define CAT_BUF_LEN     24     // longest command: PBllllhhhh;
+#define CAT_MAX_BYTES   64     // bytes parsed per call
+#define CAT_ANSWER_LEN  40     // IF answer is 38
+#define CAT_REPORT_LEN  2048   // debug page being sent, power of 2
+
+Stream             *catPort = NULL;
+char                catBuf[CAT_BUF_LEN];
+uint8_t             catLen = 0;
+boolean             bCatOverflow = false;   // discard up to the next ';'
+
+uint32_t            catCommands = 0;
+uint32_t            catErrors = 0;
+uint32_t            catDropped = 0;         // answers not sent, port full
+
+// Statistics page n on out, false if there is no such page
+bool Telemetry_Report(int page, Print &out);
+
+//************************************************************************
+//      Debug page buffer: filled at once, drained by Cat_Poll()
+//************************************************************************
+class CatReport : public Print
+{
+public:
+  size_t write(uint8_t b) {
+    if (pending() >= CAT_REPORT_LEN - 1) {
+      lost++;
+      return 0;
+    }
+    buf[head++ & (CAT_REPORT_LEN - 1)] = b;
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  int availableForWrite() { return CAT_REPORT_LEN - 1 - pending(); }
+
+  uint32_t pending() { return head - tail; }
+
+  // as much as the port takes now
+  void send(Print &out) {
+    uint32_t n = pending();
+    uint32_t room = out.availableForWrite();
+    if (n > room) n = room;
+    while (n) {
+      uint32_t pos = tail & (CAT_REPORT_LEN - 1);
+      uint32_t run = CAT_REPORT_LEN - pos;
+      if (run > n) run = n;
+      out.write((const uint8_t *)&buf[pos], run);
+      tail += run;
+      n -= run;
+    }
+  }
+
+  uint32_t lost = 0;             // bytes that did not fit
+
+private:
+  char     buf[CAT_REPORT_LEN];
+  uint32_t head = 0;
+  uint32_t tail = 0;
+};
+
+CatReport           catReport;
+
+//************************************************************************
+//      Helpers
+//************************************************************************
+int Cat_LabelIndex(const char *label, const char *const *table, int n)
+{
+  for (int i = 0; i < n; i++)
+    if (strcmp(label, table[i]) == 0) return i;
+  return -1;
+}
+
+// Digits only, exactly n of them from p; -1 if not
+int64_t Cat_Number(const char *p, int n)
+{
+  int64_t v = 0;
+  for (int i = 0; i < n; i++) {
+    if (p[i] < '0' || p[i] > '9') return -1;
+    v = v * 10 + (p[i] - '0');
+  }
+  return v;
+}
+
+void Cat_Send(Print &out, const char *answer)
+{
+  size_t len = strlen(answer);
+  // behind a debug page still being sent
+  if (catReport.pending()) {
+    if (catReport.availableForWrite() < (int)len) catDropped++;
+    else catReport.print(answer);
+    return;
+  }
+  // Teensy USB serial: room in the transmit buffer, never wait for it
+  if (out.availableForWrite() < (int)len) {
+    catDropped++;
+    return;
+  }
+  out.write((const uint8_t *)answer, len);
+}
+
+// Kenwood mode of the demodulation in use
+int Cat_Mode()
+{
+  static const uint8_t KENWOOD_MODE[] = {3, 3, 2, 1, 5, 5, 6};   // MODE_LABELS order
+  int k = Cat_LabelIndex(newMode, MODE_LABELS, sizeof(MODE_LABELS) / sizeof(MODE_LABELS[0]));
+  return k < 0 ? 0 : KENWOOD_MODE[k];
+}
+
+// S-meter on the TS-2000 scale: S0-S9 is 0-15, S9+60 is 30
+int Cat_Smeter()
+{
+  float v;
+  if (smeterAvgDbm <= SMETER_DBM_S9)
+    v = (smeterAvgDbm - SMETER_DBM_MIN) / 6.0 * 15.0 / 9.0;
+  else
+    v = 15.0 + (smeterAvgDbm - SMETER_DBM_S9) * 15.0 / 60.0;
+  return constrain((int)(v + 0.5), 0, 30);
+}
+
+//************************************************************************
+//      One command, without the ';'
+//************************************************************************
+static const uint16_t FILTER_WIDTHS[] = {500, 2100, 2700, 3100, 3900};   // FILTER_LABELS order
+
+boolean Cat_Execute(const char *cmd, int len, char *answer)
+{
+  if (len < 2) return false;
+  const char *arg = cmd + 2;
+  int n = len - 2;
+  answer[0] = 0;
+
+  if (cmd[0] == 'F' && cmd[1] == 'A') {
+    if (n == 0) {
+      snprintf(answer, CAT_ANSWER_LEN, "FA%011lu;", (unsigned long)vfoFreq);
+      return true;
+    }
+    int64_t f = (n == 11) ? Cat_Number(arg, 11) : -1;
+    if (f < bottomFreq || f > topFreq) return false;
+    vfoFreq = f;
+    applyFreq();
+    return true;
+  }
+
+  if (cmd[0] == 'M' && cmd[1] == 'D') {
+    if (n == 0) {
+      snprintf(answer, CAT_ANSWER_LEN, "MD%d;", Cat_Mode());
+      return true;
+    }
+    // Kenwood mode to MODE_LABELS index, -1 not available (FM)
+    static const int8_t MODE_INDEX[] = {-1, 3, 2, 1, -1, 4, 6, 1, -1, 6};
+    int32_t m = (n == 1) ? Cat_Number(arg, 1) : -1;
+    if (m < 0 || MODE_INDEX[m] < 0) return false;
+    mndx = MODE_INDEX[m];     // tuningMode() applies mndx
+    tuningMode();
+    return true;
+  }
+
+  if (cmd[0] == 'F' && cmd[1] == 'W') {
+    const int nFilters = sizeof(FILTER_WIDTHS) / sizeof(FILTER_WIDTHS[0]);
+    if (n == 0) {
+      int k = Cat_LabelIndex(newFilter, FILTER_LABELS, nFilters);
+      snprintf(answer, CAT_ANSWER_LEN, "FW%04d;", k < 0 ? 0 : FILTER_WIDTHS[k]);
+      return true;
+    }
+    int32_t w = (n == 4) ? Cat_Number(arg, 4) : -1;
+    if (w < 0) return false;
+    int k = 0;
+    while (k < nFilters - 1 && FILTER_WIDTHS[k] < w) k++;
+    fndx = k;                 // filterMode() applies fndx
+    filterMode();
+    return true;
+  }
+
+  if (cmd[0] == 'I' && cmd[1] == 'F' && n == 0) {
+    // freq, step, RIT/XIT offset, RIT, XIT, bank, channel, RX, mode,
+    // VFO A, no scan, no split, no tone, tone number, P15
+    snprintf(answer, CAT_ANSWER_LEN, "IF%011lu     +0000000000%d000000 ;",
+             (unsigned long)vfoFreq, Cat_Mode());
+    return true;
+  }
+
+  if (cmd[0] == 'S' && cmd[1] == 'M' && (n == 0 || (n == 1 && arg[0] == '0'))) {
+    snprintf(answer, CAT_ANSWER_LEN, "SM0%04d;", Cat_Smeter());
+    return true;
+  }
+
+  if (cmd[0] == 'P' && cmd[1] == 'B') {
+    if (n == 0) {
+      snprintf(answer, CAT_ANSWER_LEN, "PB%04d%04d;", (int)dFLoCut, (int)dFHiCut);
+      return true;
+    }
+    int32_t lo = (n == 8) ? Cat_Number(arg, 4) : -1;
+    int32_t hi = (n == 8) ? Cat_Number(arg + 4, 4) : -1;
+    if (lo < MIN_LOW || lo > MAX_LOW || hi < MIN_HI || hi > MAX_HI) return false;
+    dFLoCut = lo;
+    dFHiCut = hi;
+    reInitializeFilter(dFLoCut, dFHiCut);
+    showPBT();
+    return true;
+  }
+
+  if (cmd[0] == 'N' && cmd[1] == 'R') {
+    const int nNR = sizeof(NR_LABELS) / sizeof(NR_LABELS[0]);
+    if (n == 0) {
+      int k = Cat_LabelIndex(newNR, NR_LABELS, nNR);
+      snprintf(answer, CAT_ANSWER_LEN, "NR%d;", k < 0 ? 0 : k);
+      return true;
+    }
+    int32_t k = (n == 1) ? Cat_Number(arg, 1) : -1;
+    if (k < 0 || k >= nNR) return false;
+    nrndx = (k + nNR - 1) % nNR;   // setNRMode() steps to the next one
+    setNRMode();
+    return true;
+  }
+
+  if (cmd[0] == 'D' && cmd[1] == 'B') {
+    int32_t page = (n == 0) ? 0 : (n == 1) ? Cat_Number(arg, 1) : -1;
+    if (page < 0 || !Telemetry_Report(page, catReport)) return false;
+    snprintf(answer, CAT_ANSWER_LEN, "DB%d;", (int)page);
+    return true;
+  }
+
+  return false;
+}
+
+//************************************************************************
+//      Parser, a character at a time
+//************************************************************************
+void Cat_Feed(char c, Print &out)
+{
+  char answer[CAT_ANSWER_LEN];
+
+  if (c == '\r' || c == '\n') return;
+
+  if (c != ';') {
+    if (catLen < CAT_BUF_LEN) catBuf[catLen++] = toupper((unsigned char)c);
+    else bCatOverflow = true;
+    return;
+  }
+
+  catCommands++;
+  if (!bCatOverflow && Cat_Execute(catBuf, catLen, answer)) {
+    if (answer[0]) Cat_Send(out, answer);
+  } else {
+    catErrors++;
+    Cat_Send(out, "?;");
+  }
+  catLen = 0;
+  bCatOverflow = false;
+}
+
+void Cat_Poll()
+{
+  for (int i = 0; i < CAT_MAX_BYTES && catPort->available() > 0; i++)
+    Cat_Feed(catPort->read(), *catPort);
+  catReport.send(*catPort);
+}
+
+bool Cat_Ready()
+{
+  return catPort->available() > 0 || catReport.pending() > 0;
+}
+
+void initCat(Stream &port)
+{
+  catPort = &port;
+  catLen = 0;
+  bCatOverflow = false;
+}
+
+#endif /* RDSP_CAT_H_INCLUDED */
+
+/**************************************END OF FILE****/
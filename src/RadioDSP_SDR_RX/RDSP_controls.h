@@ -16,6 +16,7 @@
 #include "RDSP_general_includes.h"
 #include "RDSP_convolutional.h"
 #include "RDSP_display.h"
+#include "RDSP_input.h"
 
 extern Encoder   Position;
 extern AudioSDR  SDR;
@@ -86,49 +87,49 @@ void tuningStep(int iMaxTuning)
   if (tndx == 0)
   {
     Fstep = 1;
-    newTs = "1Hz";
+    newTs = TS_LABELS[0];
     tft.fillRect(202, 37, 320, 10,   ILI9341_BLACK );
     tft.fillRect(204, 37, 15, 4,    ILI9341_GREEN );
   }
   if (tndx == 1)
   {
     Fstep = 10;
-    newTs = "10Hz";
+    newTs = TS_LABELS[1];
     tft.fillRect(202, 37, 320, 10,    ILI9341_BLACK );
     tft.fillRect(288, 37, 15, 5,    ILI9341_GREEN );
   }
   if (tndx == 2)
   {
     Fstep = 100;
-    newTs = "100Hz";
+    newTs = TS_LABELS[2];
     tft.fillRect(200, 37, 320, 10,    ILI9341_BLACK );
     tft.fillRect(272, 37, 15, 5,    ILI9341_GREEN );
   }
   if (tndx == 3)
   {
     Fstep = 1000;
-    newTs = "1kHz";
+    newTs = TS_LABELS[3];
     tft.fillRect(200, 37, 320, 10,    ILI9341_BLACK );
     tft.fillRect(248, 37, 15, 5,    ILI9341_GREEN );
   }
   if (tndx == 4)
   {
     Fstep = 10000;
-    newTs = "10 kHz";
+    newTs = TS_LABELS[4];
     tft.fillRect(200, 37, 320, 10,    ILI9341_BLACK );
     tft.fillRect(232, 37, 15, 5,    ILI9341_GREEN );
   }
   if (tndx == 5)
   {
     Fstep = 100000;
-    newTs = "100 kHz";
+    newTs = TS_LABELS[5];
     tft.fillRect(200, 37, 320, 10,    ILI9341_BLACK );
     tft.fillRect(216, 37, 15, 5,    ILI9341_GREEN );
   }
   if (tndx == 6)
   {
     Fstep = 1000000;
-    newTs = "1 MHz";
+    newTs = TS_LABELS[6];
     tft.fillRect(200, 37, 320, 10,    ILI9341_BLACK );
     tft.fillRect(200, 37, 15, 5,    ILI9341_GREEN );
   }
@@ -140,7 +141,6 @@ void tuningStep(int iMaxTuning)
   {
     tndx = tndx + 1;
   }
-  delay(200);
 }
 
 //************************************************************************
@@ -151,31 +151,31 @@ void filterMode()
   if(fndx==0)
   { 
    SDR.setAudioFilter(audioCW);
-   newFilter= "500 Hz";
+   newFilter= FILTER_LABELS[0];
   }
  
   if(fndx==1)
   {
    SDR.setAudioFilter(audio2100);
-   newFilter= "2.1 kHz";
+   newFilter= FILTER_LABELS[1];
   }
 
   if(fndx==2)
   {
    SDR.setAudioFilter(audio2700);
-   newFilter= "2.7 kHz";
+   newFilter= FILTER_LABELS[2];
   }
 
   if(fndx==3)
   {
     SDR.setAudioFilter(audio3100);
-    newFilter= "3.1 kHz";
+    newFilter= FILTER_LABELS[3];
   }
   
   if(fndx==4)
   {
     SDR.setAudioFilter(audioAM);
-    newFilter= "3.9 kHz";
+    newFilter= FILTER_LABELS[4];
   }
 
   if(fndx==4)
@@ -187,7 +187,6 @@ void filterMode()
    fndx= fndx+1;
   }
   showFilter();
-  delay(200);
 }
 
 //************************************************************************
@@ -198,25 +197,25 @@ void setAgc()
   if(andx==0)
   { 
    SDR.setAGCmode(AGCoff);
-   newAgc= "AGC O";
+   newAgc= AGC_LABELS[0];
   }
  
   if(andx==1)
   {
    SDR.setAGCmode(AGCfast);
-   newAgc= "AGC F";
+   newAgc= AGC_LABELS[1];
   }
 
   if(andx==2)
   {
    SDR.setAGCmode(AGCmedium);
-   newAgc= "AGC M";
+   newAgc= AGC_LABELS[2];
   }
 
   if(andx==3)
   {
     SDR.setAGCmode(AGCslow);
-   newAgc= "AGC S";
+   newAgc= AGC_LABELS[3];
   }
   
   if(andx==3)
@@ -228,7 +227,6 @@ void setAgc()
    andx= andx+1;
   }
   showAgcMode();
-  delay(200);
 }
 
 //************************************************************************
@@ -236,7 +234,7 @@ void setAgc()
 //************************************************************************
 void setNRMode()
 {
-  if(nrndx==5)
+  if(nrndx==7)
   {
     nrndx=0;
   }
@@ -249,7 +247,7 @@ void setNRMode()
   { 
    SDR.disableALSfilter();
    SDR.enableAGC();  
-   newNR= "";
+   newNR= NR_LABELS[0];
    nr_level = 0;
   }
   
@@ -259,14 +257,14 @@ void setNRMode()
    SDR.enableALSfilter();
    SDR.setALSfilterNotch();
    SDR.setALSfilterAdaptive();
-   newNR= "NOTCH";
+   newNR= NR_LABELS[1];
   }
 
   if(nrndx==2)
   {
    SDR.disableALSfilter();
    //SDR.disableAGC();  
-   newNR= "DNR 1";
+   newNR= NR_LABELS[2];
    nr_level = 20;
   }
 
@@ -274,7 +272,7 @@ void setNRMode()
   {
    SDR.disableALSfilter();
    //SDR.disableAGC();  
-   newNR= "DNR 2";
+   newNR= NR_LABELS[3];
    nr_level = 30;
   }
 
@@ -282,18 +280,35 @@ void setNRMode()
   {
    SDR.disableALSfilter();
    //SDR.disableAGC();  
-   newNR= "DNR 3";
+   newNR= NR_LABELS[4];
    nr_level = 40;
   }
   if(nrndx==5)
   {
    SDR.disableALSfilter();
    //SDR.disableAGC();  
-   newNR= "DNR 4";
+   newNR= NR_LABELS[5];
    nr_level = 50;
   }
+
+  // Bypass: no convolutional filter, the q15 LMS on the audio blocks
+  // as automatic notch or as DNR
+  if(nrndx==6)
+  {
+   SDR.disableALSfilter();
+   newNR= NR_LABELS[6];
+   nr_level = 30;
+   iBypassLMSMode = LMS_Q15_NOTCH;
+  }
+  if(nrndx==7)
+  {
+   SDR.disableALSfilter();
+   newNR= NR_LABELS[7];
+   nr_level = 30;
+   iBypassLMSMode = LMS_Q15_NR;
+  }
+  bBypassMode = (nrndx >= 6);
   showNRMode();
-  delay(200);
 }
 
 //************************************************************************
@@ -303,15 +318,26 @@ void setScopeMode()
 {
   if(nscope==0)
   { 
-   newNR= "Panad";
+   newNR= SCOPE_LABELS[0];
   }
   if(nscope==1)
   {
-   newNR= "Audio";
+   newNR= SCOPE_LABELS[1];
   }
-  if(nscope==1)
+  if(nscope==2)
+  {
+   newNR= SCOPE_LABELS[2];
+  }
+  if(nscope==3)
+  {
+   newNR= SCOPE_LABELS[3];
+  }
+  if(nscope==3)
   {
     nscope=0;
+    // back to the full span, the zoomed history does not fit the axis
+    Pan_EnableZoom(false);
+    Pan_ClearHistory();
   }
   else
   {
@@ -320,8 +346,15 @@ void setScopeMode()
   // Clean scope zone
   tft.fillRect(0, 52, 260, 160, ILI9341_BLACK );
 
+  if (nscope==2) initScrollWaterfall();
+  if (nscope==3)
+  {
+    endScrollWaterfall();
+    Pan_ClearHistory();
+    Pan_EnableZoom(true);
+  }
+
   //showScopeMode();
-  delay(200);
 }
 
 //************************************************************************
@@ -331,62 +364,76 @@ void tuningMode()
 {
    if(mndx==0)
   {
-    newMode="CW N";
+    newMode=MODE_LABELS[0];
+    LMS_SetPreset(LMS_PRESET_CW);
     SDR.setAudioFilter(audioCW);
     if (vfoFreq > 10000000){
       TuningOffset = SDR.setDemodMode(CW_USBmode); 
+      iSideband = 1;
     }else{
       TuningOffset = SDR.setDemodMode(CW_LSBmode); 
+      iSideband = -1;
     }
-    newFilter= "500 Hz";
+    newFilter= FILTER_LABELS[0];
   }
  
   if(mndx==1)
   {
-   newMode="CW";
+   newMode=MODE_LABELS[1];
+    LMS_SetPreset(LMS_PRESET_CW);
    SDR.setAudioFilter(audio2100);
    if (vfoFreq > 10000000){
       TuningOffset = SDR.setDemodMode(CW_USBmode); 
+      iSideband = 1;
     }else{
       TuningOffset = SDR.setDemodMode(CW_LSBmode); 
+      iSideband = -1;
     }
-   newFilter= "2.1 kHz";
+   newFilter= FILTER_LABELS[1];
    fndx=2;
   }
 
   if(mndx==2)
   {
-   newMode="USB";
+   newMode=MODE_LABELS[2];
+    LMS_SetPreset(LMS_PRESET_SSB);
    SDR.setAudioFilter(audio2700);
    TuningOffset = SDR.setDemodMode(USBmode); 
-   newFilter= "2.7 kHz";
+   iSideband = 1;
+   newFilter= FILTER_LABELS[2];
    fndx=2;
   }
 
   if(mndx==3)
   {
-    newMode="LSB";
+    newMode=MODE_LABELS[3];
+    LMS_SetPreset(LMS_PRESET_SSB);
     SDR.setAudioFilter(audio2700);
     TuningOffset = SDR.setDemodMode(LSBmode); 
-    newFilter= "2.7 kHz";
+    iSideband = -1;
+    newFilter= FILTER_LABELS[2];
     fndx=2;
   }
   
   if(mndx==4)
   {
-    newMode="AM";
+    newMode=MODE_LABELS[4];
+    LMS_SetPreset(LMS_PRESET_AM);
     SDR.setAudioFilter(audioAM);
     TuningOffset = SDR.setDemodMode(AMmode);
-    newFilter= "3.9 kHz";
+    iSideband = 0;
+    newFilter= FILTER_LABELS[4];
     fndx=4;
   }
 
   if(mndx==5)
   {
-    newMode="SAM";
+    newMode=MODE_LABELS[5];
+    LMS_SetPreset(LMS_PRESET_AM);
     SDR.setAudioFilter(audioAM);
     TuningOffset = SDR.setDemodMode(SAMmode);
-    newFilter= "3.9 kHz";
+    iSideband = 0;
+    newFilter= FILTER_LABELS[4];
     fndx=4;
   }
 /*
@@ -402,10 +449,12 @@ void tuningMode()
  */ 
    if(mndx==6)
   {
-    newMode="RTTY";
+    newMode=MODE_LABELS[6];
+    LMS_SetPreset(LMS_PRESET_SSB);
     SDR.setAudioFilter(audio2100);
     TuningOffset = SDR.setDemodMode(USBmode);
-    newFilter= "2.1 kHz";
+    iSideband = 1;
+    newFilter= FILTER_LABELS[1];
     fndx=1;
   }
 
@@ -419,10 +468,126 @@ void tuningMode()
   }
   showMode();
   showFilter();
-  delay(200);
 }
 
 
+//************************************************************************
+//         VFO fast retune
+//************************************************************************
+// With PLLA fixed at 800 MHz a retune changes only the 8 registers of
+// MultiSynth 0 (42..49). The plan is computed here with the same integer
+// math of the Si5351 library and compared with the image of what the chip
+// holds: only the span of registers that differ is written, in a single
+// I2C burst. The library set_freq() is still used out of this range (R
+// divider below 512 kHz, PLL moved above 100 MHz) and to bring the chip to
+// a known state, after which the image is valid.
+#define VFO_PLL_FREQ    80000000000ULL   // SI5351_PLL_FIXED, 0.01 Hz
+#define VFO_FAST_MIN    51200000ULL      // 512 kHz, R divider below
+#define VFO_FAST_MAX    10000000000ULL   // 100 MHz, PLL moved above
+#define VFO_MS_DENOM    1000000ULL       // RFRAC_DENOM of the library
+#define VFO_MS0_REG     42               // SI5351_CLK0_PARAMETERS
+#define VFO_I2C_CLOCK   400000
+
+uint8_t             vfoRegs[8];              // MS0 registers in the chip
+boolean             bVfoRegsValid = false;   // vfoRegs matches the chip
+boolean             bVfoPllMoved = false;    // PLLA is not at VFO_PLL_FREQ
+
+uint32_t            vfoFastWrites = 0;
+uint32_t            vfoSlowWrites = 0;
+uint32_t            vfoSkipped = 0;          // same registers, nothing sent
+uint32_t            vfoBytes = 0;            // bytes of the fast writes
+uint32_t            vfoLastMicros = 0;
+uint32_t            vfoMaxFastMicros = 0;
+uint32_t            vfoMaxSlowMicros = 0;
+
+// MS0 registers for freq (0.01 Hz): divider a + b / c from the fixed PLL
+void Vfo_Plan(uint64_t freq, uint8_t *regs)
+{
+  uint32_t a = VFO_PLL_FREQ / freq;
+  uint32_t b = (VFO_PLL_FREQ % freq * VFO_MS_DENOM) / freq;
+  uint32_t c = b ? VFO_MS_DENOM : 1;
+
+  uint32_t p1 = 128 * a + ((128 * b) / c) - 512;
+  uint32_t p2 = 128 * b - c * ((128 * b) / c);
+  uint32_t p3 = c;
+
+  regs[0] = (p3 >> 8) & 0xFF;
+  regs[1] = p3 & 0xFF;
+  regs[2] = (p1 >> 16) & 0x03;    // R divider 1, no divide by 4
+  regs[3] = (p1 >> 8) & 0xFF;
+  regs[4] = p1 & 0xFF;
+  regs[5] = ((p3 >> 12) & 0xF0) | ((p2 >> 16) & 0x0F);
+  regs[6] = (p2 >> 8) & 0xFF;
+  regs[7] = p2 & 0xFF;
+}
+
+void Vfo_SlowDone(uint32_t t0)
+{
+  vfoLastMicros = micros() - t0;
+  if (vfoLastMicros > vfoMaxSlowMicros) vfoMaxSlowMicros = vfoLastMicros;
+  vfoSlowWrites++;
+}
+
+// CLK0 to freq (0.01 Hz)
+void Vfo_SetFreq(uint64_t freq)
+{
+  uint32_t t0 = micros();
+  uint8_t regs[8];
+
+  if (freq < VFO_FAST_MIN || freq > VFO_FAST_MAX) {
+    si5351.set_freq(freq, SI5351_CLK0);
+    if (freq > VFO_FAST_MAX) bVfoPllMoved = true;
+    bVfoRegsValid = false;
+    Vfo_SlowDone(t0);
+    return;
+  }
+
+  Vfo_Plan(freq, regs);
+
+  if (!bVfoRegsValid) {
+    if (bVfoPllMoved) {
+      si5351.set_pll(SI5351_PLL_FIXED, SI5351_PLLA);
+      bVfoPllMoved = false;
+    }
+    si5351.set_freq(freq, SI5351_CLK0);
+    memcpy(vfoRegs, regs, sizeof(vfoRegs));
+    bVfoRegsValid = true;
+    Vfo_SlowDone(t0);
+    return;
+  }
+
+  int first = 0, last = 7;
+  while (first < 8 && regs[first] == vfoRegs[first]) first++;
+  if (first == 8) {
+    vfoSkipped++;
+    return;
+  }
+  while (regs[last] == vfoRegs[last]) last--;
+
+  Wire.beginTransmission(SI5351_BUS_BASE_ADDR);
+  Wire.write(VFO_MS0_REG + first);
+  Wire.write(&regs[first], last - first + 1);
+  if (Wire.endTransmission() != 0) {
+    // state of the chip unknown, the next one goes through the library
+    bVfoRegsValid = false;
+    return;
+  }
+  memcpy(vfoRegs, regs, sizeof(vfoRegs));
+
+  vfoLastMicros = micros() - t0;
+  if (vfoLastMicros > vfoMaxFastMicros) vfoMaxFastMicros = vfoLastMicros;
+  vfoFastWrites++;
+  vfoBytes += last - first + 1;
+}
+
+// Retune statistics, CAT debug page 2 (DB2;)
+void Vfo_Report(Print &out)
+{
+  out.printf("vfo fast %lu (max %lu us, %lu bytes)  slow %lu (max %lu us)  skipped %lu  last %lu us\n",
+             vfoFastWrites, vfoMaxFastMicros, vfoBytes, vfoSlowWrites, vfoMaxSlowMicros,
+             vfoSkipped, vfoLastMicros);
+}
+
 //************************************************************************
 //         VFO Initializzation routine
 //************************************************************************
@@ -431,6 +596,7 @@ void initVfo()
   delay(50);
   
   si5351.init(SI5351_CRYSTAL_LOAD_8PF, 0, 0);
+  Wire.setClock(VFO_I2C_CLOCK);   // the Si5351 runs the I2C fast mode
   si5351.set_correction(33000, SI5351_PLL_INPUT_XO);
   si5351.set_pll(SI5351_PLL_FIXED, SI5351_PLLA);
   si5351.drive_strength(SI5351_CLK0, SI5351_DRIVE_2MA);
@@ -444,7 +610,7 @@ void initVfo()
 //************************************************************************
 void sendFreq()
 { //delay(10);
-  si5351.set_freq((vfoFreq - TuningOffset) * 400ULL, SI5351_CLK0); // generating 4 x frequency ... set 400ULL to 100ULL for 1x frequency
+  Vfo_SetFreq((vfoFreq - TuningOffset) * 400ULL); // generating 4 x frequency ... set 400ULL to 100ULL for 1x frequency
 }
 
 //************************************************************************
@@ -482,83 +648,13 @@ void showFreq()
       }
     }
 
-    if (vfoFreq < 99999 )
-    {
-      tft.setFont(Arial_20);
-      tft.setCursor(184, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(200, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(216, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(232, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(232, 15);
-      tft.setTextColor(ILI9341_WHITE);
-      tft.print((float)vfoFreq / 1000, MAX_DECIMAL_TUNING);
-
-      // Set the maximum allowabe tuning step range
-      maxTS = 4;
-    }
-    
-     if (vfoFreq < 999999 && vfoFreq >= 99999)
-    {
-      tft.setFont(Arial_20);
-      tft.setCursor(184, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(200, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(216, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(216, 15);
-      tft.setTextColor(ILI9341_WHITE);
-      tft.print((float)vfoFreq / 1000, MAX_DECIMAL_TUNING);
-
-      // Set the maximum allowabe tuning step range
-      maxTS = 5;
-    }
-   
-     if (vfoFreq < 9999999 && vfoFreq >= 999999)
-    {
-      tft.setFont(Arial_20);
-      tft.setCursor(184, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(200, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(200, 15);
-      tft.setTextColor(ILI9341_WHITE);
-      tft.print((float)vfoFreq / 1000, MAX_DECIMAL_TUNING);
-
-      // Set the maximum allowabe tuning step range
-      maxTS = 6;
-    }
-    
-    if (vfoFreq >= 9999999)
-    
-    {
-      tft.setCursor(200, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setFont(Arial_20);
-      tft.setCursor(184, 15);
-      tft.setTextColor(ILI9341_BLACK);
-      tft.print((float)Freq / 1000, MAX_DECIMAL_TUNING);
-      tft.setCursor(184, 15);
-      tft.setTextColor(ILI9341_WHITE);
-      tft.print((float)vfoFreq / 1000, MAX_DECIMAL_TUNING);
-
-      // Set the maximum allowabe tuning step range
-      maxTS = 6;
-    }
+    // Set the maximum allowabe tuning step range
+    if (vfoFreq < 99999) maxTS = 4;
+    else if (vfoFreq < 999999) maxTS = 5;
+    else maxTS = 6;
+
+    // only the digits that changed are drawn
+    drawFreqDisplay(vfoFreq);
   }
   Freq = vfoFreq; // update oldfreq
 }
@@ -570,14 +666,14 @@ boolean checkPBT_Increase(){
 
    if (iMenuLevel == L4_PBT_LH){
           // Increase LOCUT
-      if (digitalRead(BUTTON_D3) == LOW){
+      if (Input_IsDown(BTN_LEFT)){
           dFLoCut = (dFLoCut + 50)<=MAX_LOW?(dFLoCut + 50):dFLoCut;
           reInitializeFilter(dFLoCut, dFHiCut);
           showPBT();
           return true;
       }
       // Increase HICUT
-      else if (digitalRead(BUTTON_D6) == LOW){
+      else if (Input_IsDown(BTN_RIGHT)){
           dFHiCut = (dFHiCut + 50)<=MAX_HI?(dFHiCut + 50):dFHiCut;
           reInitializeFilter(dFLoCut, dFHiCut);
           showPBT();
@@ -591,7 +687,7 @@ boolean checkPBT_Decrease(){
 
    if (iMenuLevel == L4_PBT_LH){
         // Decrease LOCUT
-  if (digitalRead(BUTTON_D3) == LOW){
+  if (Input_IsDown(BTN_LEFT)){
       dFLoCut = (dFLoCut - 50)>MIN_LOW?(dFLoCut - 50):dFLoCut;
       if (dFLoCut<0.0) dFLoCut=0.0;
       reInitializeFilter(dFLoCut, dFHiCut); 
@@ -600,7 +696,7 @@ boolean checkPBT_Decrease(){
   }
 
         // Decrease HICUT
-  else  if (digitalRead(BUTTON_D6) == LOW){
+  else  if (Input_IsDown(BTN_RIGHT)){
       dFHiCut = (dFHiCut - 50)>MIN_HI?(dFHiCut - 50):dFHiCut;
       reInitializeFilter(dFLoCut, dFHiCut);
       showPBT();
@@ -611,57 +707,87 @@ boolean checkPBT_Decrease(){
     return false;
 }
 
+//************************************************************************
+//         Tuning acceleration
+//************************************************************************
+// The step grows with the speed of the knob (clicks per second): x10 over
+// TUNE_ACCEL_MID, x100 over TUNE_ACCEL_FAST, not beyond TUNE_ACCEL_MAX
+// (or Fstep if larger) and not beyond the largest step of the band
+#define TUNE_ACCEL_MID    8
+#define TUNE_ACCEL_FAST   20
+#define TUNE_ACCEL_MAX    10000
+
+uint32_t tuneAccelStep()
+{
+  int32_t clicks = encVelocity / ENC_COUNTS_PER_DETENT;
+  uint32_t step = Fstep;
+
+  if (clicks >= TUNE_ACCEL_FAST) step *= 100;
+  else if (clicks >= TUNE_ACCEL_MID) step *= 10;
+
+  uint32_t maxStep = 1;
+  for (int i = 0; i < maxTS; i++) maxStep *= 10;
+  if (maxStep > TUNE_ACCEL_MAX) maxStep = max((uint32_t)TUNE_ACCEL_MAX, (uint32_t)Fstep);
+  return min(step, maxStep);
+}
+
+// Move by clicks steps; the first one lands on the grid of the step
+uint32_t tuneMove(uint32_t freq, int32_t clicks, uint32_t step)
+{
+  int64_t f;
+
+  if (clicks > 0) f = (int64_t)(freq / step) * step + (int64_t)clicks * step;
+  else f = (int64_t)((freq + step - 1) / step) * step + (int64_t)clicks * step;
+
+  if (f >= topFreq) f = topFreq;
+  if (f <= bottomFreq) f = bottomFreq;
+  return (uint32_t)f;
+}
+
+//************************************************************************
+//         Apply vfoFreq to the panel and to the VFO
+//************************************************************************
+void applyFreq()
+{
+  // start of the tuning latency, up to the new digits on the panel
+  if (vfoFreq != Freq && !tunePending) {
+    tunePending = true;
+    tuneStartMicros = micros();
+  }
+  showFreq(); // show freq on display
+  sendFreq(); // send freq to SI5351
+}
+
 //************************************************************************
 //         Change Frequency method
 //************************************************************************
+// The knob is read by the input sampler: all the clicks since the last
+// call are applied, the part of a click left stays for the next one.
 void setFreq()
 {
+  newPosition = encCount;
+
   if (iMode == RUNNING_MODE) {
-    newPosition = Position.read();
-    if (newPosition != oldPosition)
+    int32_t clicks = (newPosition - oldPosition) / ENC_COUNTS_PER_DETENT;
+    if (clicks != 0)
     { 
       // Speedup the scope ...
       intervalSpc = 0;
 
-      if (newPosition > oldPosition  || newPosition < oldPosition )
-      {
-        if (newPosition > oldPosition)
-        {
-          // if we are changing the PBT
-          boolean bChecked = checkPBT_Increase();
-          if (!bChecked){
-            // change freq
-            vfoFreq = (Freq + Fstep);
-            if (vfoFreq >= topFreq)
-            {
-              vfoFreq = topFreq;
-            }
-          }
-        }
-
-        if (newPosition < oldPosition)
-        {
-          // if we are changing the PBT
-          boolean bChecked = checkPBT_Decrease();
-          if (!bChecked){
-            // change freq
-            vfoFreq = (Freq - Fstep);
-            if (vfoFreq <= bottomFreq)
-            {
-              vfoFreq = bottomFreq;
-            }
-          }
-        }
+      // if we are changing the PBT
+      boolean bChecked = (clicks > 0) ? checkPBT_Increase() : checkPBT_Decrease();
+      if (!bChecked){
+        // change freq
+        vfoFreq = tuneMove(Freq, clicks, tuneAccelStep());
       }
-      showFreq(); // show freq on display
-      sendFreq(); // send freq to SI5351
-      oldPosition = newPosition; //update oldposition
+
+      applyFreq();
+      oldPosition += clicks * ENC_COUNTS_PER_DETENT; //update oldposition
     }else{
       // Slow down the scope ...
       intervalSpc = SPC_SLOW;
     }
   } else {
-    newPosition = Position.read();
     if (newPosition != oldPosition)
     {
       if (newPosition > oldPosition + 5 || newPosition < oldPosition - 5)
@@ -684,23 +810,32 @@ void setFreq()
 //************************************************************************
 //        Check the menu level
 //************************************************************************
+// A button acts on PRESS, LEFT and RIGHT again on each REPEAT while held
 void checkCmd()
 {
-  if (digitalRead(BUTTON_D2) == LOW) {
-   iMode = (iMode == MENU_MODE) ? RUNNING_MODE : MENU_MODE;
-   tft.fillRect(99, 222, 150, 240, ILI9341_BLACK );
- 
-   if (iMode == MENU_MODE) {
-     tft.setTextColor(ILI9341_GREEN, ILI9341_BLACK);
-     tft.setFont(Arial_10_Bold);
-     tft.setCursor(100, 226);
-     tft.print("MENU SET");
-   }
-  }
+  uint8_t event;
+
+  while ((event = Input_GetEvent()) != BTN_EV_NONE) {
+    int button = BTN_EVENT_BUTTON(event);
+    int type = BTN_EVENT_TYPE(event);
+
+    if (button == BTN_MENU && type == BTN_EV_PRESS) {
+     iMode = (iMode == MENU_MODE) ? RUNNING_MODE : MENU_MODE;
+     tft.fillRect(99, 222, 150, 240, ILI9341_BLACK );
+
+     if (iMode == MENU_MODE) {
+       tft.setTextColor(ILI9341_GREEN, ILI9341_BLACK);
+       tft.setFont(Arial_10_Bold);
+       tft.setCursor(100, 226);
+       tft.print("MENU SET");
+     }
+     continue;
+    }
 
-  if (iMode == RUNNING_MODE) {
+    if (iMode != RUNNING_MODE) continue;
+    if (type != BTN_EV_PRESS && type != BTN_EV_REPEAT) continue;
 
-    if (digitalRead(BUTTON_D3) == LOW) {
+    if (button == BTN_LEFT) {
       switch (iMenuLevel) {
         case L1_MODE_TS:
           {
@@ -719,11 +854,11 @@ void checkCmd()
           }
          case L4_PBT_LH:
           {
-            // do nothing
+            // held while turning the knob
             break;
           }  
       }
-    } else if (digitalRead(BUTTON_D6) == LOW) {
+    } else if (button == BTN_RIGHT) {
       switch (iMenuLevel) {
         case L1_MODE_TS:
           {
@@ -742,7 +877,7 @@ void checkCmd()
           }
         case L4_PBT_LH:
           {
-            // do nothing
+            // held while turning the knob
             break;
           }    
       }
@@ -324,7 +324,7 @@ void doConvolutionalProcessing(float iNRLevel, boolean bFilterEnabled, double dF
 
        // apply the LMS but with single block.
        if ( iNRLevel >0){ 
-         if (iNRLevel!=oldNRLevel){
+         if (iNRLevel!=oldNRLevel || LMS_reinit){
             Init_LMS_NR (iNRLevel);
             oldNRLevel = iNRLevel;
          }
@@ -352,6 +352,46 @@ void doConvolutionalProcessing(float iNRLevel, boolean bFilterEnabled, double dF
     } // end of audio process loop
 }
 
+/*- Bypass processing: no convolutional filter, the DNR/notch runs in fixed point on the audio blocks */
+void doBypassProcessing(int iNRLevel, int iOutMode){
+
+    if (Q_in_L.available() > N_BLOCKS + 0 && Q_in_R.available() > N_BLOCKS + 0)
+    {
+      static int oldNRLevel_q15 = 0;
+      if (iNRLevel > 0 && (iNRLevel != oldNRLevel_q15 || iOutMode != LMS_q15_outMode)){
+         Init_LMS_NR_q15 (iNRLevel, iOutMode);
+         oldNRLevel_q15 = iNRLevel;
+      }
+
+      for (unsigned i = 0; i < N_BLOCKS; i++)
+      {
+        sp_L = Q_in_L.readBuffer();
+        sp_R = Q_in_R.readBuffer();
+
+        int16_t *out_L = Q_out_L.getBuffer();
+        int16_t *out_R = Q_out_R.getBuffer();
+        arm_copy_q15 (sp_L, out_L, BUFFER_SIZE);
+
+        if (iNRLevel > 0){
+          LMS_NoiseReduction_q15(BUFFER_SIZE, out_L);
+          arm_copy_q15 (out_L, out_R, BUFFER_SIZE);
+        }else{
+          arm_copy_q15 (sp_R, out_R, BUFFER_SIZE);
+        }
+
+        Q_in_L.freeBuffer();
+        Q_in_R.freeBuffer();
+        Q_out_L.playBuffer();
+        Q_out_R.playBuffer();
+      }
+    }
+}
+
+/*- Audio behind: after the processing a full group of blocks is still waiting */
+boolean audioBacklog(){
+  return Q_in_L.available() > N_BLOCKS && Q_in_R.available() > N_BLOCKS;
+}
+
 #endif /* RDSP_CONVOLUTIONAL_H_INCLUDED */
 
 /**************************************END OF FILE****/
@@ -14,6 +14,9 @@
 #define RDSP_DISPLAY_H_INCLUDED
 
 #include "RDSP_general_includes.h"
+#include "RDSP_noise_reduction.h"
+#include "utility/dspinst.h"
+#include "RDSP_spectrum_smooth.h"
 
 // For optimized ILI9341_t3 library
 #define TFT_DC    9
@@ -24,23 +27,163 @@
 #define TFT_MISO  12
 
 extern ILI9341_t3n tft;
-extern AudioAnalyzeFFT256IQ   FFT;
-extern AudioAnalyzeFFT1024     AudioFFT;
+extern PanadapterFFT          FFT;
+extern AudioAnalyzeFFTIQ<PANADAPTER_ZOOM_SIZE> ZoomFFT;
+extern AudioAnalyzeFFT1024Sync AudioFFT;
+
+// Waterfall history: circular buffer of rows, one byte per displayed
+// column. wfHead is the newest row, the older ones follow it.
+uint8_t  WaterfallData[MAX_WATERFALL][WATERFALL_COLS];
+int      wfHead = 0;
+boolean  wfRowsPending = false;   // rows not yet drawn by Render_Waterfall
+
+// Waterfall colors: 256 entries RGB565 palette indexed by the pixel
+// value of the spectrum (0..80 is the bar range), see setWaterfallColormap
+#define WF_COLORMAP_CLASSIC  0   // same steps of the old version, smoothed
+#define WF_COLORMAP_GRAY     1
+#define WF_COLORMAP_JET      2
+uint16_t WaterfallPalette[256];
+unsigned long wfRenderMicros = 0;  // time spent by the last waterfall render (DB1;)
+
+// Build the palette interpolating the control points (value, r, g, b)
+void setWaterfallColormap(int iMap)
+{
+  static const uint8_t classic[][4] = {
+    {0, 0, 0, 0}, {5, 0, 0, 128}, {15, 0, 0, 255}, {25, 255, 255, 0},
+    {40, 255, 165, 0}, {50, 255, 0, 255}, {75, 255, 0, 0}, {255, 255, 0, 0}
+  };
+  static const uint8_t gray[][4] = {
+    {0, 0, 0, 0}, {80, 255, 255, 255}, {255, 255, 255, 255}
+  };
+  static const uint8_t jet[][4] = {
+    {0, 0, 0, 64}, {16, 0, 0, 255}, {32, 0, 255, 255}, {48, 255, 255, 0},
+    {64, 255, 0, 0}, {80, 128, 0, 0}, {255, 128, 0, 0}
+  };
+  const uint8_t (*points)[4];
+  int nPoints;
+
+  switch (iMap) {
+    case WF_COLORMAP_GRAY: points = gray; nPoints = sizeof(gray) / 4; break;
+    case WF_COLORMAP_JET:  points = jet;  nPoints = sizeof(jet) / 4;  break;
+    default:               points = classic; nPoints = sizeof(classic) / 4; break;
+  }
 
-uint16_t WaterfallData[MAX_WATERFALL][512] = {1};
+  for (int p = 0; p < nPoints - 1; p++) {
+    int v0 = points[p][0], v1 = points[p + 1][0];
+    for (int v = v0; v <= v1; v++) {
+      int t = (v1 > v0) ? ((v - v0) * 256) / (v1 - v0) : 0;
+      uint8_t r = points[p][1] + (((points[p + 1][1] - points[p][1]) * t) >> 8);
+      uint8_t g = points[p][2] + (((points[p + 1][2] - points[p][2]) * t) >> 8);
+      uint8_t b = points[p][3] + (((points[p + 1][3] - points[p][3]) * t) >> 8);
+      WaterfallPalette[v] = ILI9341_t3n::color565(r, g, b);
+    }
+  }
+}
 uint16_t SpectrumView[512] = {1};
-uint16_t SpectrumViewOld[512] = {1};
+
+// Panadapter scale: the FFT output is in dB q8.8, the floor is the
+// level shown as zero and the shift sets the pixels per dB (7 = 2 px/dB)
+#define SPECTRUM_DB_FLOOR   (6 * 256)
+#define SPECTRUM_PX_SHIFT   7
 
 // Frame buffer DMA memory for ILI9341_t3n display
 DMAMEM uint16_t fb1[320 * 240];
 
 //*************************************************************************
-// Variable timer
+// Variable timer: 0 while tuning, the render scheduler uses the fast rates
 unsigned long       SPC_SLOW = 200;
-unsigned long       timeSpc = 0;
-unsigned long       lastTimeSpc = 0;
 unsigned long       intervalSpc = SPC_SLOW;
 
+//************************************************************************
+//      Frequency readout: kHz with two decimals in fixed Arial_20 cells
+//************************************************************************
+// The glyphs are rendered once into a cache, then only the cells whose
+// character changed are written with writeRect (a blank cell is a black
+// fillRect). Cells: 5 digits of kHz, the dot, 2 decimals.
+#define FREQ_X            184
+#define FREQ_Y            15
+#define FREQ_CELLS        8
+#define FREQ_DOT_CELL     5
+#define FREQ_CELL_H       22      // Arial_20 cap height + 2, the step marker is below
+#define FREQ_CELL_W_MAX   24
+
+uint16_t freqGlyph[11][FREQ_CELL_W_MAX * FREQ_CELL_H];  // '0'..'9', '.'
+int      freqDigitW = 16;
+int      freqDotW = 8;
+char     freqShown[FREQ_CELLS];   // characters on the screen, 0 = unknown
+
+// Tuning latency: from the poll that reads the encoder change to the
+// end of the DMA update that sent the new digits to the panel (the wait
+// for the next encoder poll is not counted), on the CAT debug page 1
+boolean       tunePending = false;
+boolean       tuneDrawn = false;
+boolean       tuneSent = false;
+unsigned long tuneStartMicros = 0;
+unsigned long tuneLatencyMicros = 0;
+unsigned long tuneLatencyMaxMicros = 0;
+
+int freqCellX(int cell)
+{
+  if (cell <= FREQ_DOT_CELL) return FREQ_X + cell * freqDigitW;
+  return FREQ_X + FREQ_DOT_CELL * freqDigitW + freqDotW + (cell - FREQ_DOT_CELL - 1) * freqDigitW;
+}
+
+void initFreqDisplay()
+{
+  char glyph[2] = "0";
+
+  tft.setFont(Arial_20);
+  tft.setTextColor(ILI9341_WHITE);
+  freqDigitW = min((int)tft.strPixelLen("0"), FREQ_CELL_W_MAX);
+  freqDotW = min((int)tft.strPixelLen("."), FREQ_CELL_W_MAX);
+
+  // draw each glyph in the frame buffer and keep a copy of its cell
+  for (int g = 0; g < 11; g++)
+  {
+    int w = (g < 10) ? freqDigitW : freqDotW;
+    glyph[0] = (g < 10) ? '0' + g : '.';
+    tft.fillRect(FREQ_X, FREQ_Y, w, FREQ_CELL_H, ILI9341_BLACK);
+    tft.setCursor(FREQ_X, FREQ_Y);
+    tft.print(glyph);
+    tft.readRect(FREQ_X, FREQ_Y, w, FREQ_CELL_H, freqGlyph[g]);
+  }
+  tft.fillRect(FREQ_X, FREQ_Y, freqCellX(FREQ_CELLS) - FREQ_X, FREQ_CELL_H, ILI9341_BLACK);
+  memset(freqShown, 0, sizeof(freqShown));
+}
+
+void drawFreqDisplay(uint32_t freq)
+{
+  char txt[FREQ_CELLS];
+  uint32_t v = (freq + 5) / 10;   // 10 Hz units, rounded as print() did
+
+  for (int cell = FREQ_CELLS - 1; cell >= 0; cell--)
+  {
+    if (cell == FREQ_DOT_CELL) {
+      txt[cell] = '.';
+      continue;
+    }
+    // no leading zeros before the kHz units
+    txt[cell] = (v || cell >= FREQ_DOT_CELL - 1) ? '0' + v % 10 : ' ';
+    v /= 10;
+  }
+
+  for (int cell = 0; cell < FREQ_CELLS; cell++)
+  {
+    if (txt[cell] == freqShown[cell]) continue;
+
+    int x = freqCellX(cell);
+    if (txt[cell] == ' ')
+      tft.fillRect(x, FREQ_Y, freqDigitW, FREQ_CELL_H, ILI9341_BLACK);
+    else if (txt[cell] == '.')
+      tft.writeRect(x, FREQ_Y, freqDotW, FREQ_CELL_H, freqGlyph[10]);
+    else
+      tft.writeRect(x, FREQ_Y, freqDigitW, FREQ_CELL_H, freqGlyph[txt[cell] - '0']);
+    freqShown[cell] = txt[cell];
+  }
+
+  if (tunePending) tuneDrawn = true;
+}
+
 //************************************************************************
 //         Display Initializzation routine
 //************************************************************************
@@ -63,8 +206,11 @@ void initDisplay()
   tft.drawLine(0, 220, 320, 220, ILI9341_CYAN);
   tft.drawLine(175, 0, 175, 51, ILI9341_CYAN);
 
-  // Start the DMA update ...
-  tft.updateScreenAsync(true);
+  setWaterfallColormap(WF_COLORMAP_CLASSIC);
+  setSpectrumSmoothing(14, 6, 3, 1);   // 0.7 / 0.3 / 0.15 normalized
+  initFreqDisplay();
+
+  // the first frame goes out with Update_Display()
 
 }
 
@@ -73,7 +219,7 @@ void initDisplay()
 //************************************************************************
 void showMode()
 {
-  if (mode != newMode)
+  if (strcmp(mode, newMode) != 0)
   {
     tft.setFont(Arial_10_Bold);
     tft.setTextColor(ILI9341_BLACK);
@@ -82,7 +228,7 @@ void showMode()
     tft.setCursor(270, 60 );
     tft.setTextColor(ILI9341_WHITE);
     tft.print(newMode);
-    mode = newMode;
+    strlcpy(mode, newMode, sizeof(mode));
   }
 }
 
@@ -91,7 +237,7 @@ void showMode()
 //************************************************************************
 void showFilter()
 {
-  if (filter != newFilter)
+  if (strcmp(filter, newFilter) != 0)
   {
     tft.setFont(Arial_10_Bold);
     tft.setTextColor(ILI9341_BLACK);
@@ -100,7 +246,7 @@ void showFilter()
     tft.setCursor(270, 75 );
     tft.setTextColor(ILI9341_WHITE);
     tft.print(newFilter);
-    filter = newFilter;
+    strlcpy(filter, newFilter, sizeof(filter));
   }
 }
 
@@ -109,7 +255,7 @@ void showFilter()
 //************************************************************************
 void showNRMode()
 {
-  if (nr != newNR)
+  if (strcmp(nr, newNR) != 0)
   {
     tft.setFont(Arial_10_Bold);
     tft.setTextColor(ILI9341_BLACK);
@@ -118,7 +264,7 @@ void showNRMode()
     tft.setCursor(270, 105 );
     tft.setTextColor(ILI9341_WHITE);
     tft.print(newNR);
-    nr = newNR;
+    strlcpy(nr, newNR, sizeof(nr));
   }
 }
 
@@ -158,7 +304,7 @@ void showPBT()
 //************************************************************************
 void showAgcMode()
 {
-  if (agc != newAgc)
+  if (strcmp(agc, newAgc) != 0)
   {
     tft.setFont(Arial_10_Bold);
     tft.setTextColor(ILI9341_BLACK);
@@ -167,7 +313,7 @@ void showAgcMode()
     tft.setCursor(270, 90 );
     tft.setTextColor(ILI9341_WHITE);
     tft.print(newAgc);
-    agc = newAgc;
+    strlcpy(agc, newAgc, sizeof(agc));
   }
 }
 
@@ -176,7 +322,7 @@ void showAgcMode()
 //************************************************************************
 void showTS()
 {
-  if (Ts != newTs)
+  if (strcmp(Ts, newTs) != 0)
   {
     tft.setFont(Arial_8);
     tft.setTextColor(ILI9341_BLACK);
@@ -185,14 +331,14 @@ void showTS()
     tft.setTextColor(ILI9341_WHITE  );
     tft.setCursor(5, 40);
     tft.print(newTs);
-    Ts = newTs;
+    strlcpy(Ts, newTs, sizeof(Ts));
   }
 }
 
 //************************************************************************
 //      Place button display on screen
 //************************************************************************
-void  MENU_SetButtons(String leftButtonLabel, String rightButtonLabel){
+void  MENU_SetButtons(const char *leftButtonLabel, const char *rightButtonLabel){
   
       tft.fillRect(1, 222, 60, 240, ILI9341_BLACK );
       tft.fillRect(220, 222, 300, 240, ILI9341_BLACK );
@@ -212,16 +358,18 @@ void Update_AudioSpectrum()
   int bar = 0;
   int xPos = 0;
   int low = 5;
+  const uint16_t *output = AudioFFT.lockFrame();
 
   // Spectrum
   for (int x = 0; x <= 100; x++)
   {
-    bar = abs(AudioFFT.output[x]*5);
+    bar = abs(output[x]*5);
     if (bar > 70) bar = 70;
     tft.drawFastVLine(146 + (xPos), (POSITION_SPECTRUM -1) - bar, bar, ILI9341_ORANGE); //draw green bar
     tft.drawFastVLine(146 + (xPos), (POSITION_SPECTRUM -100), 100 - bar, ILI9341_BLACK);  //finish off with black to the top of the screen
     xPos++;
   }
+  AudioFFT.unlockFrame();
 
   tft.setFont(Arial_8);
   tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
@@ -229,6 +377,111 @@ void Update_AudioSpectrum()
   tft.print("0  0.5k  1.5k  2.5k  3.5k");
 }
 
+uint32_t smoothCycles = 0;       // cycles of the last run of the kernel
+
+//************************************************************************
+//       Smooth the last analyzer frame in SpectrumView (pixels)
+//************************************************************************
+#if PANADAPTER_BINS > PANADAPTER_ZOOM_SIZE
+#define SPECTRUM_MAX_BINS  PANADAPTER_BINS
+#else
+#define SPECTRUM_MAX_BINS  PANADAPTER_ZOOM_SIZE
+#endif
+int16_t SpectrumSmooth[SPECTRUM_MAX_BINS];   // smoothed spectrum, dB q8.8
+
+// Width of the panadapter bins, Hz
+float Pan_BinHz()
+{
+#ifdef PANADAPTER_FFT_SIZE
+  return FFT.binWidth();
+#else
+  return AUDIO_SAMPLE_RATE_EXACT / 256.0;
+#endif
+}
+
+//************************************************************************
+//       Zoom scope: the panadapter shows ZoomFFT, centered on the carrier
+//************************************************************************
+uint32_t panZoomOffset = 0;      // TuningOffset the zoom analyzer is mixing
+
+boolean Pan_Zoomed() { return nscope == 3; }
+
+// a new mode can move the carrier: retune the mixer only
+void Pan_FollowTuning()
+{
+  if (TuningOffset == panZoomOffset) return;
+  ZoomFFT.setOffset(TuningOffset);
+  panZoomOffset = TuningOffset;
+}
+
+// the zoom analyzer runs only while its view is shown
+void Pan_EnableZoom(boolean bEnable)
+{
+  if (bEnable) Pan_FollowTuning();
+  ZoomFFT.enable(bEnable);
+}
+
+uint32_t Pan_Sequence()
+{
+  return Pan_Zoomed() ? ZoomFFT.frameSequence() : FFT.frameSequence();
+}
+
+// Screen x of a frequency (Hz from the LO) in the shown spectrum, the
+// columns are the even display bins
+int Pan_X(float f)
+{
+  int   bins = Pan_Zoomed() ? PANADAPTER_ZOOM_SIZE : PANADAPTER_BINS;
+  float binHz = Pan_Zoomed() ? ZoomFFT.binWidth() : Pan_BinHz();
+  float center = Pan_Zoomed() ? (float)TuningOffset : 0.0;
+  int   bin = constrain(bins / 2 - 1 - (int)lroundf((f - center) / binHz), 0, bins - 1);
+  return 2 + 2 * ((bin * 256 / bins) >> 1);
+}
+
+// Receiver passband, Hz from the LO, on the demodulated side of the carrier
+void Pan_Passband(float &f1, float &f2)
+{
+  float fc = TuningOffset;
+  if (iSideband > 0)      { f1 = fc + dFLoCut; f2 = fc + dFHiCut; }
+  else if (iSideband < 0) { f1 = fc - dFHiCut; f2 = fc - dFLoCut; }
+  else                    { f1 = fc - dFHiCut; f2 = fc + dFHiCut; }
+}
+
+// dB to pixels above the floor; a larger analyzer gives the peak of
+// each group of bins, DC stays in display bin 127
+void Prepare_SpectrumView(const uint16_t *frame, int bins)
+{
+  uint32_t cycles = ARM_DWT_CYCCNT;
+  smoothSpectrum_q15(frame, SpectrumSmooth, bins);
+  smoothCycles = ARM_DWT_CYCCNT - cycles;
+
+  const int group = bins / 256;
+  for (int x = 0; x < 256; x++){
+   int16_t peak = SpectrumSmooth[x * group];
+   for (int k = 1; k < group; k++) peak = max(peak, SpectrumSmooth[x * group + k]);
+   int32_t v = (peak - SPECTRUM_DB_FLOOR) >> SPECTRUM_PX_SHIFT;
+   SpectrumView[x] = (v < 0) ? 0 : v;
+  }
+}
+
+void Prepare_Spectrum()
+{
+  if (Pan_Zoomed()) {
+    Prepare_SpectrumView(ZoomFFT.lockFrame(), PANADAPTER_ZOOM_SIZE);
+    ZoomFFT.unlockFrame();
+  } else {
+    Prepare_SpectrumView(FFT.lockFrame(), PANADAPTER_BINS);
+    FFT.unlockFrame();
+  }
+}
+
+// the spectrum and waterfall rows of the other scale are not kept
+void Pan_ClearHistory()
+{
+  memset(SpectrumSmooth, 0, sizeof(SpectrumSmooth));
+  memset(WaterfallData, 0, sizeof(WaterfallData));
+  wfRowsPending = true;
+}
+
 //************************************************************************
 //       Show full 44KHz wide signal spectrum & Wwaterfall
 //************************************************************************
@@ -236,53 +489,42 @@ void Update_Panadapter(int iDisplayMode)
 {
   int bar = 0;
   int xPos = 0;
-  int low = 0;
-  int scale=5;
-  float avg = 0.0;
-  float LPFcoeff = 0.7; 
   int iMaxCols = 127; 
 
   // Display size
   if (iDisplayMode == 0){
-    // Full panadapter
+    // Full panadapter, with the span shown
+    char span[16];
+    float binHz = Pan_Zoomed() ? ZoomFFT.binWidth() : Pan_BinHz();
+    int   bins = Pan_Zoomed() ? PANADAPTER_ZOOM_SIZE : PANADAPTER_BINS;
+    snprintf(span, sizeof(span), "%s %4.1f kHz", Pan_Zoomed() ? "ZOOM" : "SPAN", bins * binHz / 1000.0);
     iMaxCols = 127;
     tft.drawLine(0, 70, 260, 70, ILI9341_CYAN);
     tft.setFont(Arial_9_Bold);
     tft.setTextColor(ILI9341_MAGENTA, ILI9341_BLACK);
     tft.setCursor(20, 55);
     tft.print("RX-SCOPE");
+    tft.setFont(Arial_8);
+    tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+    tft.setCursor(120, 57);
+    tft.print(span);
   }else{
     // Half panadapter
     iMaxCols = 64;
   }
 
-  // Pre process spectrum data ...
-  for (int x = 0; x < 256; x++){
-   // Frequency Smoothing 
-   // Moving window - weighted average of 5 points of the spectrum to smooth spectrum in the frequency domain
-   // Weights:  x: 50% , x-1/x+1: 36%, x+2/x-2: 14% 
-   if ((x > 1) && (x < 254))
-   {       
-       avg = FFT.output[x]*0.7 + FFT.output[x-1]*0.3 + 
-                  FFT.output[x-2]*0.15 + FFT.output[x+1]*0.3 + 
-                  FFT.output[x+2]*0.15;         
-   }else{
-       avg =  FFT.output[x];
-   }
-
-   // Time Smoothing
-   // low pass filtering of the spectrum pixels to smooth/slow down spectrum in the time domain
-   // experimental LPF for spectrum:  
-   SpectrumView[x] = LPFcoeff * 2 * sqrt (abs(avg)*scale) + (1 - LPFcoeff) * SpectrumViewOld[x];
-  
-   // Update the value for the next step ...
-   SpectrumViewOld[x]= SpectrumView[x];
-  }
+  // Smoothed spectrum in pixels
+  Prepare_Spectrum();
+
+    // New waterfall row, the oldest one is overwritten
+    wfHead = (wfHead == 0) ? MAX_WATERFALL - 1 : wfHead - 1;
+    uint8_t *newRow = WaterfallData[wfHead];
+
     // Spectrum
     for (int x = 0; x <= iMaxCols; x++)
     {
-      WaterfallData[0][xPos] = abs(SpectrumView[x*2]);
-      bar = WaterfallData[0][xPos];
+      bar = SpectrumView[x*2];
+      newRow[xPos] = (bar > 255) ? 255 : bar;
       if (bar > 80)
         bar = 80;
       tft.drawFastVLine(2 + (xPos*2), (POSITION_SPECTRUM -1) - bar, bar, ILI9341_GREEN); //draw green bar
@@ -290,98 +532,323 @@ void Update_Panadapter(int iDisplayMode)
       xPos++;
     }
   
-    // Waterfall
-    for (int row = MAX_WATERFALL-1; row >= 0; row--)
+      // Passband edges on the axis of the shown spectrum, the columns
+      // redrawn above erase them when they move
+      float f1, f2;
+      Pan_Passband(f1, f2);
+      int xMax = 2 + 2 * iMaxCols;
+      int x1 = Pan_X(f1), x2 = Pan_X(f2);
+      if (x1 > 2 && x1 < xMax) tft.drawFastVLine(x1, 70, 90, ILI9341_RED);
+      if (x2 > 2 && x2 < xMax) tft.drawFastVLine(x2, 70, 90, ILI9341_RED);
+
+    // the waterfall has a new row to show
+    wfRowsPending = true;
+}
+
+//************************************************************************
+//       Waterfall under the panadapter, iMaxCols as Update_Panadapter
+//************************************************************************
+void Render_Waterfall(int iMaxCols)
+{
+    // Waterfall, walk the rows from the newest one: each row is expanded
+    // to the screen width and written through the palette in one call
+    unsigned long wfStart = micros();
+    uint8_t wfLine[2 * WATERFALL_COLS];
+    int wfRow = wfHead;
+    for (int row = 0; row < MAX_WATERFALL; row++)
+    {
+      const uint8_t *data = WaterfallData[wfRow];
+      if (++wfRow == MAX_WATERFALL) wfRow = 0;
+
       for (int col = 0; col <= iMaxCols; col++)
       {
-        WaterfallData[row][col] = WaterfallData[row - 1][col];
-  
-        if (WaterfallData[row][col] >= low + 75)
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_RED);
-  
-        else if ((WaterfallData[row][col] >= low + 50) && (WaterfallData[row][col] < low + 75))
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_MAGENTA);
-          
-        else if ((WaterfallData[row][col] >= low + 40) && (WaterfallData[row][col] < low + 50))
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_ORANGE);  
-  
-        else if ((WaterfallData[row][col] >= low + 25) && (WaterfallData[row][col] < low + 40))
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_YELLOW);
-  
-        else if ((WaterfallData[row][col] >= low + 15) && (WaterfallData[row][col] < low + 25))
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_BLUE);
-
-        else if ((WaterfallData[row][col] >= low + 5) && (WaterfallData[row][col] < low + 15))
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_NAVY);
-          
-        else if (WaterfallData[row][col] < low + 5)
-          tft.drawPixel(2 + (col * 2), POSITION_SPECTRUM + row, ILI9341_BLACK);
-     }
-  
-      // Display the carrier Tunig line
-      tft.drawFastVLine(72, 70, 90, ILI9341_RED); //draw green bar
-      tft.drawFastVLine(100, 70, 90, ILI9341_RED); //draw green bar
+        wfLine[2 * col] = wfLine[2 * col + 1] = data[col];
+      }
+      tft.writeRect8BPP(2, POSITION_SPECTRUM + row, 2 * (iMaxCols + 1), 1, wfLine, WaterfallPalette);
+    }
+    wfRenderMicros = micros() - wfStart;
+    wfRowsPending = false;
 }
 
 //************************************************************************
-//      Evaluate value of Smeter taking some vales of rc signal bins
+//       Sweep waterfall in the scope area
 //************************************************************************
-void displayPeak(float s_sample) {
-  
-   float uv, dbuv, s;// microvolts, db-microvolts, s-units
-   char string[80];   // print format stuff
+// The waterfall fills the scope area, x 0..259 and y 51..219 between the
+// header and the footer lines: frequency is vertical (169 of the 256
+// bins, one per pixel, DC in the middle row) and time flows to the right,
+// the newest column followed by a white cursor that wraps at the labels.
+// The panel hardware scroll is not used: with rotation 3 it moves whole
+// screen columns, header and footer with them.
+// Every frame writes only the new column and the cursor: into fb1
+// directly, without marking the bands changed, and to the panel with
+// one small write, so the SPI and CPU cost does not depend on how much
+// history is shown. Update_Display() keeps sending the other drawings
+// from fb1, that holds the waterfall too; the column is written only
+// when no async update is running.
+#define WF_SCROLL_W       260    // x 0..259, left of the labels
+#define WF_SCROLL_Y       51     // below the header line at y = 50 ...
+#define WF_SCROLL_H       169    // ... down to the footer line at y = 220
+#define WF_SCROLL_FIRST_BIN (127 - WF_SCROLL_H / 2)
+
+int      wfScrollX = 0;          // column written next
+boolean  wfScrollActive = false;
+
+void initScrollWaterfall()
+{
+  // in fb1, sent by Update_Display()
+  tft.fillRect(0, WF_SCROLL_Y, WF_SCROLL_W, WF_SCROLL_H, ILI9341_BLACK);
+  wfScrollX = 0;
+  wfScrollActive = true;
+}
 
-   uv= s_sample/10 ;//* 1000;
-   
-   // do some filter to smoth the change
-   uv = 0.1*uv+0.9*uvold;
-   uvold = uv;
-
-   dbuv = 20.0*log10(uv);
-   tft.fillRect(5, 10, 160,40,    ILI9341_BLACK );
-   if (dbuv >0){
-    tft.fillRect(5, 15,abs(dbuv*2),15,    ILI9341_GREEN );
-   }
-    
-   s = 1.0 + (10.0 + dbuv*1.2)/6.0;
-   if (s <0.0) s=0.0;
-   if (s>9.0)
-   {
-      dbuv = dbuv - 34.0;
-      s = 9.0;
-   }
-   else dbuv = 0;
-     
-   // tft.fillRect(120, 5, 130,20,ILI9341_BLACK);
-   tft.setFont(Arial_12_Bold);
-   tft.setCursor(110, 15);
-   tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
-     
-   if (dbuv == 0) sprintf(string,"S:%1.0f",s);
-   else sprintf(string,"S:9+%02.0f",dbuv);
-   tft.print(string);
- 
+void endScrollWaterfall()
+{
+  if (!wfScrollActive) return;
+  wfScrollActive = false;
+  tft.fillRect(0, WF_SCROLL_Y, WF_SCROLL_W, WF_SCROLL_H, ILI9341_BLACK);
 }
 
-void Update_smeter(){
-  
-  float specVal = 0.0; 
-  
-  // Evaluate the medium signal data for the carrier
-  for(int m = 75; m<=85; m++)  { specVal = specVal+FFT.output[m]; }
-  displayPeak(abs(specVal/5));
+void Update_ScrollWaterfall()
+{
+  uint16_t column[WF_SCROLL_H * 2];   // new column and cursor, by rows
+  int w = (wfScrollX + 1 < WF_SCROLL_W) ? 2 : 1;
+  int width = tft.width();
+
+  // the direct write would collide with the band DMA of Update_Display()
+  if (tft.asyncUpdateActive()) return;
+
+  Prepare_Spectrum();
 
+  // lowest frequency at the bottom
+  for (int y = 0; y < WF_SCROLL_H; y++)
+  {
+    uint16_t v = SpectrumView[WF_SCROLL_FIRST_BIN + WF_SCROLL_H - 1 - y];
+    uint16_t *fb = &fb1[(WF_SCROLL_Y + y) * width + wfScrollX];
+    fb[0] = column[y * w] = WaterfallPalette[(v > 255) ? 255 : v];
+    if (w == 2) fb[1] = column[y * w + 1] = ILI9341_WHITE;
+  }
+
+  tft.useFrameBuffer(false);
+  tft.writeRect(wfScrollX, WF_SCROLL_Y, w, WF_SCROLL_H, column);
+  tft.useFrameBuffer(true);
+
+  if (++wfScrollX == WF_SCROLL_W) wfScrollX = 0;
 }
 
+//************************************************************************
+//      Send the changed parts of the frame buffer to the panel
+//************************************************************************
+// The drawings only change fb1, the driver marks the bands of 16 rows
+// they touch. At most one frame every DISPLAY_FRAME_MS: the bands marked
+// when it starts go out as runs of adjacent bands, one shot DMA per run,
+// the next run starts when the previous one is done.
+#define DISPLAY_FRAME_MS   20
+
+uint32_t      dispFrameBands = 0;    // bands still to send in this frame
+unsigned long dispLastFrame = 0;
+unsigned long dispLastSecond = 0;
+uint32_t      dispBytes = 0;         // bytes sent in the current second
+uint32_t      dispBytesPerSec = 0;   // bytes sent in the last second
+
+void Update_Display()
+{
+  unsigned long now = millis();
+
+  if (now - dispLastSecond >= 1000) {
+    dispBytesPerSec = dispBytes;
+    dispBytes = 0;
+    dispLastSecond = now;
+  }
+
+  if (tft.asyncUpdateActive()) return;
+
+  // the update with the new frequency is done
+  if (tuneSent) {
+    tuneLatencyMicros = micros() - tuneStartMicros;
+    if (tuneLatencyMicros > tuneLatencyMaxMicros) tuneLatencyMaxMicros = tuneLatencyMicros;
+    tunePending = tuneDrawn = tuneSent = false;
+  }
+
+  if (dispFrameBands == 0) {
+    if (now - dispLastFrame < DISPLAY_FRAME_MS) return;
+    dispFrameBands = tft.changedBands();
+    if (dispFrameBands == 0) return;
+    dispLastFrame = now;
+  }
+
+  // first run of adjacent bands
+  int b0 = __builtin_ctz(dispFrameBands);
+  int b1 = b0;
+  while (b1 < 31 && (dispFrameBands & (2u << b1))) b1++;
+  dispFrameBands &= ~((2u << b1) - (1u << b0));
+
+  int y0 = b0 << ILI9341_CHANGED_BAND_SHIFT;
+  int y1 = ((b1 + 1) << ILI9341_CHANGED_BAND_SHIFT) - 1;
+  if (y1 >= tft.height()) y1 = tft.height() - 1;
+
+  if (tft.updateScreenAsyncRows(y0, y1)) {
+    dispBytes += (uint32_t)(y1 - y0 + 1) * tft.width() * 2;
+    if (tuneDrawn && y0 < FREQ_Y + FREQ_CELL_H && y1 >= FREQ_Y) tuneSent = true;
+  }
+}
 
 //************************************************************************
-//       Show Helf Panadapter 22KHz & Audio Spectrum - AF-FFT
+//      S-meter: passband power in dBm and S units
 //************************************************************************
-void Update_DoubleSpectrum()
+// The power is the linear sum of the panadapter bins inside the passband
+// of the convolution filter (dFLoCut..dFHiCut on the demodulated side of
+// the carrier). The IQ analyzer sees the signal before the AGC of the
+// SDR, so the sum follows the antenna power and an offset turns
+// it into dBm. The carrier is at +TuningOffset in the IQ baseband, whose
+// positive frequencies are published on the lower bins (N/2 - 1 - f / binHz).
+
+// Analyzer dB to dBm, one value for all the bands. Not measured yet: it
+// is the estimate from the analyzer scale, the S readings are only
+// relative until the receiver is calibrated with a generator (S9, -73 dBm,
+// at the antenna reads -73). Per band calibration is still to do: the
+// front end gain changes with the band, the same offset will not fit all.
+#define SMETER_CAL_DBM  (-121.0)
+
+// Ballistics: the bar and the S reading show the average, the marker
+// the peak, held and then released at SMETER_PEAK_DECAY dB/s
+#define SMETER_AVG_MS        300
+#define SMETER_PEAK_HOLD_MS  1000
+#define SMETER_PEAK_DECAY    20.0
+
+// Bar: S0 (-127 dBm) to S9+40 (-33 dBm), green up to S9 and red above
+#define SMETER_X        5
+#define SMETER_Y        15
+#define SMETER_W        100
+#define SMETER_H        15
+#define SMETER_DBM_MIN  (-127.0)
+#define SMETER_DBM_MAX  (-33.0)
+#define SMETER_DBM_S9   (-73.0)
+
+float         smeterDbm = SMETER_DBM_MIN;      // last measure
+float         smeterAvgDbm = SMETER_DBM_MIN;
+float         smeterPeakDbm = SMETER_DBM_MIN;
+unsigned long smeterLast = 0;
+unsigned long smeterPeakTime = 0;
+
+int           smeterBarPx = 0;      // bar on the screen
+int           smeterPeakPx = -1;    // marker on the screen, -1 = none
+char          smeterText[12] = "";
+char          smeterNRText[12] = "";
+
+int Smeter_Px(float dBm)
 {
-  // Display Half panadapter
-  Update_Panadapter(1);
+  int px = (dBm - SMETER_DBM_MIN) * SMETER_W / (SMETER_DBM_MAX - SMETER_DBM_MIN);
+  if (px < 0) px = 0;
+  if (px > SMETER_W) px = SMETER_W;
+  return px;
+}
+
+// columns from..to-1 of the bar, lit or off
+void Smeter_Fill(int from, int to, boolean bOn)
+{
+  if (to <= from) return;
+  if (!bOn) {
+    tft.fillRect(SMETER_X + from, SMETER_Y, to - from, SMETER_H, ILI9341_BLACK);
+    return;
+  }
+  int s9 = Smeter_Px(SMETER_DBM_S9);
+  if (from < s9)
+    tft.fillRect(SMETER_X + from, SMETER_Y, min(to, s9) - from, SMETER_H, ILI9341_GREEN);
+  if (to > s9) {
+    int x = max(from, s9);
+    tft.fillRect(SMETER_X + x, SMETER_Y, to - x, SMETER_H, ILI9341_RED);
+  }
+}
+
+// only the columns that changed are drawn, the texts when they change
+void Smeter_Draw()
+{
+  char string[12];
+  int bar = Smeter_Px(smeterAvgDbm);
+  int peak = Smeter_Px(smeterPeakDbm);
+  if (peak > SMETER_W - 2) peak = SMETER_W - 2;
+
+  int lo = min(bar, smeterBarPx), hi = max(bar, smeterBarPx);
+  Smeter_Fill(lo, hi, bar > smeterBarPx);
+  boolean bMarkerHit = smeterPeakPx >= 0 && lo < smeterPeakPx + 2 && hi > smeterPeakPx;
+  smeterBarPx = bar;
+
+  if (peak != smeterPeakPx || bMarkerHit) {
+    if (smeterPeakPx >= 0)
+      for (int c = smeterPeakPx; c < smeterPeakPx + 2; c++) Smeter_Fill(c, c + 1, c < bar);
+    tft.fillRect(SMETER_X + peak, SMETER_Y, 2, SMETER_H, ILI9341_WHITE);
+    smeterPeakPx = peak;
+  }
+
+  // S units on the average
+  if (smeterAvgDbm > SMETER_DBM_S9)
+    snprintf(string, sizeof(string), "S:9+%02d", (int)(smeterAvgDbm - SMETER_DBM_S9 + 0.5));
+  else
+    snprintf(string, sizeof(string), "S:%d", max(0, (int)(9.5 + (smeterAvgDbm - SMETER_DBM_S9) / 6.0)));
+  if (strcmp(string, smeterText) != 0) {
+    tft.fillRect(110, 15, 55, 16, ILI9341_BLACK);
+    tft.setFont(Arial_12_Bold);
+    tft.setCursor(110, 15);
+    tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+    tft.print(string);
+    strlcpy(smeterText, string, sizeof(smeterText));
+  }
+
+  // Noise suppression achieved by the DNR (float LMS only)
+  if (nr_level > 0 && !bBypassMode) snprintf(string, sizeof(string), "NR %2.0fdB", LMS_suppression_dB);
+  else string[0] = 0;
+  if (strcmp(string, smeterNRText) != 0) {
+    tft.fillRect(110, 35, 55, 12, ILI9341_BLACK);
+    tft.setFont(Arial_8);
+    tft.setCursor(110, 35);
+    tft.setTextColor(LMS_converged ? ILI9341_GREEN : ILI9341_ORANGE, ILI9341_BLACK);
+    tft.print(string);
+    strlcpy(smeterNRText, string, sizeof(smeterNRText));
+  }
+}
 
+void Update_smeter(){
+
+  unsigned long now = millis();
+  float dt = now - smeterLast;
+  if (dt > 1000.0) dt = 1000.0;
+  smeterLast = now;
+
+  // passband on the demodulated side of the carrier, Hz from the LO
+  float f1, f2;
+  Pan_Passband(f1, f2);
+
+  const float binHz = Pan_BinHz();
+  const int   dc = PANADAPTER_BINS / 2 - 1;
+  int b1 = constrain(dc - (int)lroundf(f2 / binHz), 0, PANADAPTER_BINS - 1);
+  int b2 = constrain(dc - (int)lroundf(f1 / binHz), 0, PANADAPTER_BINS - 1);
+
+  // dB q8.8 back to linear power: 10^(dB/10) = 2^(dB * log2(10) / 10)
+  float sum = 0.0;
+  const uint16_t *output = FFT.lockFrame();
+  for (int b = b1; b <= b2; b++) sum += exp2f(output[b] * (3.3219281f / 10.0f / 256.0f));
+  FFT.unlockFrame();
+  smeterDbm = 10.0f * log10f(sum + 1e-12f) + SMETER_CAL_DBM;
+
+  // Ballistics
+  smeterAvgDbm += (smeterDbm - smeterAvgDbm) * dt / (SMETER_AVG_MS + dt);
+  if (smeterDbm >= smeterPeakDbm) {
+    smeterPeakDbm = smeterDbm;
+    smeterPeakTime = now;
+  } else if (now - smeterPeakTime > SMETER_PEAK_HOLD_MS) {
+    smeterPeakDbm -= SMETER_PEAK_DECAY * dt / 1000.0;
+    if (smeterPeakDbm < smeterDbm) smeterPeakDbm = smeterDbm;
+  }
+
+  Smeter_Draw();
+}
+
+
+//************************************************************************
+//       Audio Spectrum - AF-FFT, right of the half panadapter
+//************************************************************************
+void Update_AFScope()
+{
   // Display the Audio FFT
   Update_AudioSpectrum();
 
@@ -401,6 +868,150 @@ void Update_DoubleSpectrum()
 }
 
 
+//************************************************************************
+//      Render scheduler
+//************************************************************************
+// The display work is split in widgets, each with a refresh period (a
+// shorter one while tuning), a cost estimate and a ready test (new data
+// to show). Every loop pass runs the due and ready widgets, the longest
+// waiting first, as long as their cost fits in renderBudgetMicros: the
+// first one always runs, so a widget costlier than the budget is not
+// starved. The estimate follows the measured time, up at once and down
+// slowly. No widget runs in a pass where the audio queues are behind.
+// A widget that waits more than its period (at least RENDER_MIN_SLACK_MS)
+// after it was due and ready counts a missed deadline.
+#define RENDER_MIN_SLACK_MS  50
+
+struct RenderWidget {
+  const char    *name;
+  void          (*draw)();
+  boolean       (*ready)();
+  uint32_t      costMicros;     // estimate, updated at every run
+  uint16_t      periodMs;
+  uint16_t      tunePeriodMs;   // while the encoder is moving
+  unsigned long lastRun;        // millis()
+  unsigned long waitingSince;   // millis() when found due and ready
+  boolean       bWaiting;
+  uint32_t      runs;
+  uint32_t      missed;
+};
+
+uint32_t renderBudgetMicros = 3000;  // display time per loop pass
+uint32_t renderAudioYields = 0;      // passes left to the audio
+uint32_t renderMissed = 0;           // missed deadlines, all widgets
+
+// last analyzer frames shown by the widgets
+uint32_t rsPanSeq = 0, rsScrollSeq = 0, rsMeterSeq = 0, rsAfSeq = 0;
+
+boolean Render_PanadapterReady() { return iMode != MENU_MODE && nscope != 2 && Pan_Sequence() != rsPanSeq; }
+boolean Render_WaterfallReady()  { return iMode != MENU_MODE && nscope != 2 && wfRowsPending; }
+boolean Render_ScrollReady()     { return iMode != MENU_MODE && nscope == 2 && FFT.frameSequence() != rsScrollSeq && !tft.asyncUpdateActive(); }
+boolean Render_AFScopeReady()    { return iMode != MENU_MODE && nscope == 1 && AudioFFT.frameSequence() != rsAfSeq; }
+boolean Render_SmeterReady()     { return iMode != MENU_MODE && FFT.frameSequence() != rsMeterSeq; }
+boolean Render_StatusReady()     { return true; }
+
+// full panadapter (also zoomed), or the half one beside the AF scope
+void Render_Panadapter()   { Pan_FollowTuning(); rsPanSeq = Pan_Sequence(); Update_Panadapter(nscope == 1 ? 1 : 0); }
+void Render_WaterfallRows(){ Render_Waterfall(nscope == 1 ? 64 : 127); }
+void Render_Scroll()       { rsScrollSeq = FFT.frameSequence(); Update_ScrollWaterfall(); }
+void Render_AFScope()      { rsAfSeq = AudioFFT.frameSequence(); Update_AFScope(); }
+void Render_Smeter()       { rsMeterSeq = FFT.frameSequence(); Update_smeter(); }
+
+// the labels draw only when changed
+void Render_Status()
+{
+  showMode();
+  showFilter();
+  showNRMode();
+  showAgcMode();
+  showTS();
+}
+
+RenderWidget renderWidgets[] = {
+  // name         draw                  ready                   cost  period tune
+  {"panadapter", Render_Panadapter,    Render_PanadapterReady, 1500,  200,    0},
+  {"waterfall",  Render_WaterfallRows, Render_WaterfallReady,  2000,  200,   40},
+  {"scroll wf",  Render_Scroll,        Render_ScrollReady,      500,  200,    0},
+  {"af scope",   Render_AFScope,       Render_AFScopeReady,    1000,  200,    0},
+  {"s-meter",    Render_Smeter,        Render_SmeterReady,      300,   50,   50},
+  {"status",     Render_Status,        Render_StatusReady,      100,  100,  100},
+};
+#define RENDER_WIDGETS (sizeof(renderWidgets) / sizeof(renderWidgets[0]))
+
+void Render_Run(boolean bAudioBacklog)
+{
+  if (bAudioBacklog) {
+    renderAudioYields++;
+    return;
+  }
+
+  boolean  bTuning = (intervalSpc == 0);
+  uint32_t start = micros();
+  boolean  bFirst = true;
+
+  for (;;)
+  {
+    unsigned long now = millis();
+    uint32_t spent = micros() - start;
+    RenderWidget *next = NULL;
+
+    for (unsigned int i = 0; i < RENDER_WIDGETS; i++)
+    {
+      RenderWidget &w = renderWidgets[i];
+      uint16_t period = bTuning ? w.tunePeriodMs : w.periodMs;
+
+      if (now - w.lastRun < period) continue;
+      // checked on every pass: the mode or the panel may have changed
+      // since the widget started waiting
+      if (!w.ready()) {
+        w.bWaiting = false;
+        continue;
+      }
+      if (!w.bWaiting) {
+        w.bWaiting = true;
+        w.waitingSince = now;
+      }
+      if (!bFirst && spent + w.costMicros > renderBudgetMicros) continue;
+      if (next == NULL || (long)(w.waitingSince - next->waitingSince) < 0) next = &w;
+    }
+    if (next == NULL) return;
+
+    uint16_t period = bTuning ? next->tunePeriodMs : next->periodMs;
+    unsigned long slack = (period > RENDER_MIN_SLACK_MS) ? period : RENDER_MIN_SLACK_MS;
+    if (now - next->waitingSince > slack) {
+      next->missed++;
+      renderMissed++;
+    }
+
+    uint32_t t0 = micros();
+    next->draw();
+    uint32_t took = micros() - t0;
+    if (took > next->costMicros) next->costMicros = took;
+    else next->costMicros -= (next->costMicros - took) >> 3;
+
+    next->runs++;
+    next->lastRun = now;
+    next->bWaiting = false;
+    bFirst = false;
+  }
+}
+
+// Render statistics, CAT debug page 1 (DB1;)
+void Render_Report(Print &out)
+{
+  out.printf("render budget %lu us, audio yields %lu, missed %lu\n",
+             renderBudgetMicros, renderAudioYields, renderMissed);
+  out.printf("tune latency %lu us, max %lu us\n", tuneLatencyMicros, tuneLatencyMaxMicros);
+  out.printf("waterfall render %lu us, panel %lu bytes/s\n", wfRenderMicros, dispBytesPerSec);
+  out.printf("spectrum smoothing %lu cycles\n", smoothCycles);
+  for (unsigned int i = 0; i < RENDER_WIDGETS; i++)
+  {
+    RenderWidget &w = renderWidgets[i];
+    out.printf("%-10s cost %5lu us  runs %8lu  missed %6lu\n", w.name, w.costMicros, w.runs, w.missed);
+  }
+}
+
+
 #endif /* RDSP_DISPLAY_H_INCLUDED */
 
 /**************************************END OF FILE****/
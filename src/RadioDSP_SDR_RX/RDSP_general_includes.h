@@ -17,6 +17,61 @@
 // from I & Q --> 44.1kHz
 #include "analyze_fft256iq.h" 
 
+// Same complex analyzer with selectable size 512/1024/2048 and overlap
+#include "analyze_fftiq.h"
+
+// Float version of the 256 points analyzer, FFT done in loop()
+#include "analyze_fft256iqf.h"
+
+// Panadapter analyzer, the q15 256 points one unless defined:
+//   PANADAPTER_FLOAT_FFT     the float version (more dynamic range, FFT
+//                            out of the audio interrupt)
+//   PANADAPTER_FFT_SIZE n    AudioAnalyzeFFTIQ<n>, n = 512, 1024 or 2048
+//                            points: finer bins, the screen shows the
+//                            peak of each group of n / 256 bins
+//#define PANADAPTER_FFT_SIZE 1024
+#if defined(PANADAPTER_FFT_SIZE)
+typedef AudioAnalyzeFFTIQ<PANADAPTER_FFT_SIZE> PanadapterFFT;
+#define PANADAPTER_BINS         PANADAPTER_FFT_SIZE
+#elif defined(PANADAPTER_FLOAT_FFT)
+typedef AudioAnalyzeFFT256IQF  PanadapterFFT;
+#define PANADAPTER_BINS         256
+#else
+typedef AudioAnalyzeFFT256IQ   PanadapterFFT;
+#define PANADAPTER_BINS         256
+#endif
+
+// Zoom scope: a second analyzer mixes the carrier (TuningOffset) to DC
+// and decimates by PANADAPTER_ZOOM before a PANADAPTER_ZOOM_SIZE points
+// FFT: 512 / 8 gives 10.8 Hz bins over 5.5 kHz around the carrier
+#define PANADAPTER_ZOOM_SIZE    512
+#define PANADAPTER_ZOOM         8
+
+// The q15 analyzer uses its polyphase filter bank instead of the window:
+// a strong station does not spread on the near columns. Comment out for
+// the plain window (the filter bank costs one more MAC pass).
+#define PANADAPTER_POLYPHASE
+
+// Quadrature counts of one click of the tuning knob: 4 for the encoders
+// with a detent every full cycle, 2 or 1 for the half or quarter cycle
+// ones. Not checked on the fitted encoder: if one click moves more (or
+// less) than one tuning step, change it here or with -D.
+#ifndef ENC_COUNTS_PER_DETENT
+#define ENC_COUNTS_PER_DETENT   4
+#endif
+
+// IQ gain balance of the SDR path (setIQgainBalance), found by
+// experimentation.
+#define IQ_GAIN_BALANCE         1.020
+
+// IQ correction of the analyzers, off: they scale Q (Q' = gain * Q) and
+// which channel setIQgainBalance scales is not known here (the AudioSDR
+// source is not in this tree); the wrong direction doubles the image.
+// To enable it, put a generator tone on the panadapter, define the gain
+// as IQ_GAIN_BALANCE and check the image at the mirror frequency goes
+// down; if it goes up, use 1.0 / IQ_GAIN_BALANCE.
+//#define PANADAPTER_IQ_GAIN      IQ_GAIN_BALANCE
+
 // This is the Kurt E. ILI9341 display driver
 // Available on : https://github.com/KurtE/ILI9341_t3n
 #include "ILI9341_t3n.h"
@@ -28,7 +83,6 @@
 #include <WireIMXRT.h>    //gets installed with wire.h
 #include <WireKinetis.h>  //
 #include <Encoder.h>
-#include <Metro.h>       // task scheduler
 
 // This use the SI5351 library by Jason Milldrum
 // https://github.com/etherkit/Si5351Arduino
@@ -37,6 +91,9 @@
 // Reference to the Audio Teensy Library
 #include <Audio.h>
 
+// AF spectrum with torn-read-free output frames
+#include "analyze_fft1024sync.h"
+
 // Reference to CMSIS platform
 #include "arm_math.h"
 #include "arm_const_structs.h"
@@ -71,6 +128,7 @@ volatile uint32_t   Freq = 7055000;// previous frequency
 volatile uint32_t   Fstep = 0; // sets the tuning increment
 volatile uint32_t   vfoFreq = 7050000;
 uint32_t            TuningOffset;
+int                 iSideband = -1;    // demodulated side: 1 USB, -1 LSB, 0 both (AM)
 
 // LO-HI cut PBT
 double              dFLoCut  = 300.0;  // actual value
@@ -88,17 +146,27 @@ double              oldFHiCut = 4000.0;  // old value
 //*************************************************************************
 // DISPLAY CONTROLS
 
-String              mode;
-String              newMode;
-String              Ts;
-String              newTs;
-String              filter;
-String              newFilter;
-String              nr;
-String              newNR;
-String              agc;
-String              newAgc;
-float               uvold = 0; 
+// Labels of the settings, the new* pointers always point in these
+// tables and the show* functions copy the label on the screen in the
+// fixed buffers: no heap use after setup()
+constexpr const char *MODE_LABELS[]   = {"CW N", "CW", "USB", "LSB", "AM", "SAM", "RTTY"};
+constexpr const char *TS_LABELS[]     = {"1Hz", "10Hz", "100Hz", "1kHz", "10 kHz", "100 kHz", "1 MHz"};
+constexpr const char *FILTER_LABELS[] = {"500 Hz", "2.1 kHz", "2.7 kHz", "3.1 kHz", "3.9 kHz"};
+constexpr const char *NR_LABELS[]     = {"", "NOTCH", "DNR 1", "DNR 2", "DNR 3", "DNR 4", "Q NTCH", "Q DNR"};
+constexpr const char *SCOPE_LABELS[]  = {"Panad", "Audio", "Wfall", "Zoom"};
+constexpr const char *AGC_LABELS[]    = {"AGC O", "AGC F", "AGC M", "AGC S"};
+#define STATUS_LABEL_LEN 12   // longest label + 0
+
+char                mode[STATUS_LABEL_LEN] = "";   // shown on the screen
+const char         *newMode = "";                  // to be shown
+char                Ts[STATUS_LABEL_LEN] = "";
+const char         *newTs = "";
+char                filter[STATUS_LABEL_LEN] = "";
+const char         *newFilter = "";
+char                nr[STATUS_LABEL_LEN] = "";
+const char         *newNR = "";
+char                agc[STATUS_LABEL_LEN] = "";
+const char         *newAgc = "";
 
 int                 tndx = 3; //100 kHz
 int                 mndx = 3; //LSB
@@ -106,9 +174,11 @@ int                 fndx = 2; //audio2700 - 2.4 kHz
 int                 nrndx = 0; //NR disabled
 int                 andx = 2; //Agc medium
 int                 lock = 0;
-int                 nscope = 1; // 0 = Panadapter - 1 = Audioscope
+int                 nscope = 1; // 0 = Panadapter - 1 = Audioscope - 2 = Scrolling waterfall - 3 = Zoom
 
 int                 nr_level = 0; // no spectrum denoise
+boolean             bBypassMode = false; // true = no convolutional filter, fixed point DNR
+int                 iBypassLMSMode = 0;  // LMS_Q15_NR or LMS_Q15_NOTCH in bypass mode
 
 int                 minTS = 1;
 int                 maxTS = 6;
@@ -116,8 +186,38 @@ int                 maxTS = 6;
 //*************************************************************************
 #define MAX_DECIMAL_TUNING 2
 #define MAX_WATERFALL 50
+#define WATERFALL_COLS 128
 #define POSITION_SPECTRUM 159
 
+//*************************************************************************
+// HEAP MONITOR
+// The heap in use at the end of setup() is the reference, heapCheck()
+// counts the checks that found a different use. Both heapDelta and
+// heapChanges stay 0 if nothing allocates after setup() (a block freed
+// before the next check is not seen, what is left allocated is).
+// They are on the CAT debug page 0 (DB0;).
+#include <malloc.h>
+
+int                 heapAtSetup = 0;   // bytes in use at the end of setup()
+int                 heapLast = 0;
+int                 heapDelta = 0;     // bytes in use now - heapAtSetup
+uint32_t            heapChanges = 0;
+
+void heapMark()
+{
+  heapAtSetup = heapLast = mallinfo().uordblks;
+}
+
+void heapCheck()
+{
+  int used = mallinfo().uordblks;
+  if (used != heapLast) {
+    heapChanges++;
+    heapLast = used;
+  }
+  heapDelta = used - heapAtSetup;
+}
+
 
 #endif /* RDSP_GENERAL_INCLUDES_H_INCLUDED */
 
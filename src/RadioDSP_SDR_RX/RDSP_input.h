@@ -0,0 +1,196 @@
+/**
+  ******************************************************************************
+  * @file    RDSP_input.h
+  * @author  Giuseppe Callipo - IK8YFW - ik8yfw@libero.it
+  * @version V1.0.0
+  * @date    19-10-2026
+  * @brief   Buttons: timer sampled debouncer and event queue
+  *
+  ******************************************************************************
+  *
+  * The buttons are sampled every INPUT_SAMPLE_US by an IntervalTimer. Each
+  * one has a small state machine that gives the debounced level and the
+  * events PRESS, LONG (held INPUT_LONG_MS), REPEAT (every INPUT_REPEAT_MS
+  * after LONG) and RELEASE. The events go into a single producer (timer)
+  * single consumer (loop) ring, so the loop never waits for a button.
+  *
+  * Input_Step() has no hardware access: it can be driven by a trace of
+  * levels and times to check the state machine. On the host the pins,
+  * the knob and the timer come from a stub (test/host).
+  *
+  * The same timer reads the tuning knob: encCount is its position and
+  * encVelocity its speed, so the tuning can use the whole movement and
+  * accelerate independently of how often the loop polls it.
+  *
+   */
+
+#ifndef RDSP_INPUT_H_INCLUDED
+#define RDSP_INPUT_H_INCLUDED
+
+#ifdef ARDUINO
+#include "RDSP_general_includes.h"
+#endif
+
+#define INPUT_SAMPLE_US     1000   // sampling period of the buttons
+#define INPUT_DEBOUNCE_MS   8      // level stable for this time to change
+#define INPUT_LONG_MS       600    // held this time: LONG
+#define INPUT_REPEAT_MS     150    // then a REPEAT every this time
+
+#define INPUT_BUTTONS       3
+#define INPUT_QUEUE_SIZE    16     // power of 2
+
+// Events, in the low nibble; the button index is in the high nibble
+#define BTN_EV_NONE     0
+#define BTN_EV_PRESS    1
+#define BTN_EV_LONG     2
+#define BTN_EV_REPEAT   3
+#define BTN_EV_RELEASE  4
+
+#define BTN_EVENT(button, ev)   (uint8_t)(((button) << 4) | (ev))
+#define BTN_EVENT_BUTTON(e)     ((e) >> 4)
+#define BTN_EVENT_TYPE(e)       ((e) & 0x0F)
+
+// Buttons, index in the tables
+#define BTN_MENU    0     // BUTTON_D2
+#define BTN_LEFT    1     // BUTTON_D3
+#define BTN_RIGHT   2     // BUTTON_D6
+
+const uint8_t       inputPins[INPUT_BUTTONS] = {BUTTON_D2, BUTTON_D3, BUTTON_D6};
+
+struct ButtonState {
+  boolean   bDown;        // debounced level
+  boolean   bLong;        // LONG sent for this press
+  uint16_t  stableMs;     // raw level different from bDown since ...
+  uint32_t  downMs;       // time of the press
+  uint32_t  nextRepeatMs;
+};
+
+ButtonState         buttons[INPUT_BUTTONS];
+
+volatile uint8_t    inputQueue[INPUT_QUEUE_SIZE];
+volatile uint8_t    inputHead = 0;      // written by the timer only
+volatile uint8_t    inputTail = 0;      // written by the loop only
+volatile uint32_t   inputOverflows = 0; // events lost with the queue full
+volatile uint32_t   inputMs = 0;        // time of the sampler
+
+// Knob, counts per click: ENC_COUNTS_PER_DETENT in RDSP_general_includes.h
+#define ENC_VEL_WINDOW_MS       20  // speed measured on this window ...
+#define ENC_VEL_SHIFT           2   // ... and smoothed by 1/4 each window
+
+extern Encoder      Position;
+
+volatile int32_t    encCount = 0;       // position of the knob, counts
+volatile int32_t    encVelocity = 0;    // |speed| of the knob, counts/s
+int32_t             encWindowPos = 0;
+uint32_t            encWindowMs = 0;
+
+IntervalTimer       inputTimer;
+
+//************************************************************************
+//      One sample of a button: raw level (true = pressed) at time nowMs,
+//      elapsed dtMs from the previous sample. Returns the event or NONE.
+//************************************************************************
+uint8_t Input_Step(ButtonState &b, boolean bRawDown, uint32_t nowMs, uint16_t dtMs)
+{
+  if (bRawDown != b.bDown) {
+    b.stableMs += dtMs;
+    if (b.stableMs < INPUT_DEBOUNCE_MS) return BTN_EV_NONE;
+    b.stableMs = 0;
+    b.bDown = bRawDown;
+    if (b.bDown) {
+      b.bLong = false;
+      b.downMs = nowMs;
+      return BTN_EV_PRESS;
+    }
+    return BTN_EV_RELEASE;
+  }
+
+  b.stableMs = 0;
+  if (!b.bDown) return BTN_EV_NONE;
+
+  if (!b.bLong) {
+    if (nowMs - b.downMs >= INPUT_LONG_MS) {
+      b.bLong = true;
+      b.nextRepeatMs = nowMs + INPUT_REPEAT_MS;
+      return BTN_EV_LONG;
+    }
+  } else if ((int32_t)(nowMs - b.nextRepeatMs) >= 0) {
+    b.nextRepeatMs += INPUT_REPEAT_MS;
+    return BTN_EV_REPEAT;
+  }
+  return BTN_EV_NONE;
+}
+
+//************************************************************************
+//      Event queue, lock free: the timer moves only the head, the loop
+//      only the tail
+//************************************************************************
+void Input_Post(uint8_t event)
+{
+  uint8_t head = inputHead;
+  uint8_t next = (head + 1) & (INPUT_QUEUE_SIZE - 1);
+  if (next == inputTail) {
+    inputOverflows++;
+    return;
+  }
+  inputQueue[head] = event;
+  __DMB();               // the event is in memory before the new head
+  inputHead = next;
+}
+
+uint8_t Input_GetEvent()
+{
+  uint8_t tail = inputTail;
+  if (tail == inputHead) return BTN_EV_NONE;
+  __DMB();
+  uint8_t event = inputQueue[tail];
+  inputTail = (tail + 1) & (INPUT_QUEUE_SIZE - 1);
+  return event;
+}
+
+//************************************************************************
+//      Sampler, from the IntervalTimer
+//************************************************************************
+void Input_Sample()
+{
+  const uint16_t dtMs = INPUT_SAMPLE_US / 1000;
+  uint32_t nowMs = inputMs + dtMs;
+  inputMs = nowMs;
+
+  for (int i = 0; i < INPUT_BUTTONS; i++) {
+    uint8_t ev = Input_Step(buttons[i], digitalReadFast(inputPins[i]) == LOW, nowMs, dtMs);
+    if (ev != BTN_EV_NONE) Input_Post(BTN_EVENT(i, ev));
+  }
+
+  // Knob position and speed
+  int32_t pos = Position.read();
+  encCount = pos;
+  if (nowMs - encWindowMs >= ENC_VEL_WINDOW_MS) {
+    int32_t rate = abs(pos - encWindowPos) * (1000 / ENC_VEL_WINDOW_MS);
+    encVelocity += (rate - encVelocity) >> ENC_VEL_SHIFT;
+    encWindowPos = pos;
+    encWindowMs = nowMs;
+  }
+}
+
+//************************************************************************
+//      Debounced level, for the buttons held while turning the knob
+//************************************************************************
+boolean Input_IsDown(int button)
+{
+  return buttons[button].bDown;
+}
+
+void initInput()
+{
+  for (int i = 0; i < INPUT_BUTTONS; i++) {
+    pinMode(inputPins[i], INPUT_PULLUP);
+    buttons[i] = {false, false, 0, 0, 0};
+  }
+  encCount = encWindowPos = Position.read();
+  inputTimer.begin(Input_Sample, INPUT_SAMPLE_US);
+}
+
+#endif /* RDSP_INPUT_H_INCLUDED */
+
+/**************************************END OF FILE****/
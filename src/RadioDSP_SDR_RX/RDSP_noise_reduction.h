@@ -31,12 +31,56 @@ float32_t  LMS_StateF32[MAX_LMS_TAPS + MAX_LMS_DELAY];
 float32_t  LMS_NormCoeff_f32[MAX_LMS_TAPS + MAX_LMS_DELAY];
 float32_t  LMS_nr_delay[256 + MAX_LMS_DELAY];
 
+// Cycles used by the last call of each LMS flavour, CAT debug page 3
+uint32_t   LMS_cycles_f32 = 0;
+uint32_t   LMS_cycles_q15 = 0;
+
+//************************************************************************
+//      Leaky NLMS presets per demodulation mode
+//************************************************************************
+// CW wants a long filter with short de-correlation delay (narrow tones),
+// SSB/AM a shorter filter and a longer delay so the voice is not seen as
+// noise. The leakage keeps the coefficients bounded on strong-noise bands.
+typedef struct {
+  uint16_t  taps;
+  uint16_t  delay;
+  float32_t leak;      // coefficient leakage applied once per block
+  float32_t muScale;   // multiplier of the user "mu"
+} LMS_preset_t;
+
+#define LMS_PRESET_CW   0
+#define LMS_PRESET_SSB  1
+#define LMS_PRESET_AM   2
+
+const LMS_preset_t LMS_presets[] = {
+  { 96,  16, 0.0005, 1.0 },   // CW
+  { 64,  96, 0.0010, 1.0 },   // SSB
+  { 48, 128, 0.0020, 0.7 },   // AM
+};
+
+int        LMS_preset = LMS_PRESET_SSB;
+uint16_t   LMS_delay = 96;
+float32_t  LMS_leak_gain = 1.0;
+float32_t  LMS_mu_nominal = 0.0;
+boolean    LMS_reinit = false;
+
+// Convergence monitor: smoothed error-to-signal ratio of the filter,
+// and noise suppression achieved (input / output power, in dB).
+// On pure noise nothing can be predicted and the ratio settles near 1,
+// so only a ratio well above 1 (the filter adds power) means divergence;
+// between the two thresholds "mu" is left alone.
+#define LMS_ESR_DIVERGED    1.5
+#define LMS_ESR_CONVERGED   0.5
+#define LMS_MU_MIN_FRACTION 0.0625
+float32_t  LMS_esr = 1.0;
+boolean    LMS_converged = false;
+float32_t  LMS_suppression_dB = 0.0;
+
 // Initialize LMS (DSP Noise reduction) filter
 void Init_LMS_NR (int LMS_nr_strength)
 {
-
- // LMS_nr_strength = 20;
-  uint16_t  calc_taps = 96;//48;
+  const LMS_preset_t *preset = &LMS_presets[LMS_preset];
+  uint16_t  calc_taps = preset->taps;
   float32_t mu_calc;
 
   LMS_Norm_instance.numTaps = calc_taps;
@@ -53,32 +97,249 @@ void Init_LMS_NR (int LMS_nr_strength)
   mu_calc /= 10;  // convert from "bels" to "deci-bels"
   mu_calc = powf(10, mu_calc);  // convert to ratio
   mu_calc = 1 / mu_calc;    // invert to fraction
-  LMS_Norm_instance.mu = mu_calc;
+  mu_calc *= preset->muScale;
+  LMS_mu_nominal = mu_calc;
+
+  LMS_delay = preset->delay;
+  LMS_leak_gain = 1.0 - preset->leak;
 
-  arm_fill_f32(0.0, LMS_nr_delay, 256 + 128);
-  arm_fill_f32(0.0, LMS_StateF32, calc_taps + 128);
+  arm_fill_f32(0.0, LMS_nr_delay, 256 + MAX_LMS_DELAY);
+  arm_fill_f32(0.0, LMS_StateF32, MAX_LMS_TAPS + MAX_LMS_DELAY);
+  arm_fill_f32(0.0, LMS_NormCoeff_f32, MAX_LMS_TAPS);
 
   // use "canned" init to initialize the filter coefficients
   arm_lms_norm_init_f32(&LMS_Norm_instance, calc_taps, &LMS_NormCoeff_f32[0], &LMS_StateF32[0], mu_calc, 128);
 
+  LMS_esr = 1.0;
+  LMS_converged = false;
+  LMS_suppression_dB = 0.0;
+  LMS_reinit = false;
+}
+
+// Select the preset for the demodulation mode, active at the next Init_LMS_NR
+void LMS_SetPreset(int iPreset)
+{
+  if (iPreset != LMS_preset) {
+    LMS_preset = iPreset;
+    LMS_reinit = true;
+  }
+}
+
+// Track the error-to-signal ratio, back off "mu" when the filter diverges
+// and let it come back to the nominal value when it is converged again.
+// Returns false when the filter had to be restarted (the output block is
+// not valid).
+static boolean LMS_monitor(float32_t pSig, float32_t pErr, float32_t pOut)
+{
+  const float32_t eps = 1e-12;
+  boolean bValid = true;
+
+  // a NaN or Inf in the filter cannot recover, restart from zero: the
+  // coefficients, the state and the input energy kept by the instance
+  if (!(pOut < 1e6)) {
+    arm_fill_f32(0.0, LMS_NormCoeff_f32, LMS_Norm_instance.numTaps);
+    arm_fill_f32(0.0, LMS_StateF32, MAX_LMS_TAPS + MAX_LMS_DELAY);
+    LMS_Norm_instance.energy = 0.0;
+    LMS_Norm_instance.x0 = 0.0;
+    pErr = pSig;
+    pOut = 0.0;
+    bValid = false;
+  }
+
+  LMS_esr = 0.9 * LMS_esr + 0.1 * (pErr / (pSig + eps));
+
+  if (LMS_esr > LMS_ESR_DIVERGED) {
+    LMS_converged = false;
+    if (LMS_Norm_instance.mu > LMS_mu_nominal * LMS_MU_MIN_FRACTION)
+      LMS_Norm_instance.mu *= 0.5;
+  } else if (LMS_esr < LMS_ESR_CONVERGED) {
+    LMS_converged = true;
+    if (LMS_Norm_instance.mu < LMS_mu_nominal)
+      LMS_Norm_instance.mu *= 1.05;
+    if (LMS_Norm_instance.mu > LMS_mu_nominal)
+      LMS_Norm_instance.mu = LMS_mu_nominal;
+  }
+
+  LMS_suppression_dB = 0.95 * LMS_suppression_dB + 0.05 * 10.0 * log10f((pSig + eps) / (pOut + eps));
+  return bValid;
 }
 
 void LMS_NoiseReduction(int16_t blockSize, float32_t *nrbuffer)
 {
-	
-  static ulong    lms1_inbuf = 0, lms1_outbuf = 0;
+  uint32_t        cycles = ARM_DWT_CYCCNT;
+  float32_t       pSig, pErr, pOut;
+
+  // de-correlation line: [ last LMS_delay samples | current block ]
+  // the filter sees the delayed signal and predicts the current one
+  arm_copy_f32(nrbuffer, &LMS_nr_delay[LMS_delay], blockSize);
+  arm_power_f32(nrbuffer, blockSize, &pSig);
+
+  arm_lms_norm_f32(&LMS_Norm_instance, LMS_nr_delay, &LMS_nr_delay[LMS_delay], nrbuffer, LMS_errsig1, blockSize);  // do noise reduction
+
+  // leaky NLMS: pull the coefficients a little towards zero every block
+  arm_scale_f32(LMS_NormCoeff_f32, LMS_leak_gain, LMS_NormCoeff_f32, LMS_Norm_instance.numTaps);
+
+  // keep the tail for the next block
+  arm_copy_f32(&LMS_nr_delay[blockSize], LMS_nr_delay, LMS_delay);
+
+  arm_power_f32(LMS_errsig1, blockSize, &pErr);
+  arm_power_f32(nrbuffer, blockSize, &pOut);
+  if (!LMS_monitor(pSig, pErr, pOut)) arm_fill_f32(0.0, nrbuffer, blockSize);
+
+  LMS_cycles_f32 = ARM_DWT_CYCCNT - cycles;
+}
+
+
+//************************************************************************
+//      Fixed point NLMS (q15) for bypass / low power modes
+//************************************************************************
+// The same de-correlation structure of the float version, but working
+// directly on the q15 audio blocks of the Teensy Audio library: no
+// float conversion is needed. The same instance can work as DNR (the
+// filter output is the correlated part of the signal) or as automatic
+// notch (the error is the signal without the periodic tones).
+#define LMS_Q15_NR       0
+#define LMS_Q15_NOTCH    1
+
+// Headroom management: the block is shifted before the filter so that
+// the peak stays near LMS_Q15_TARGET_PEAK, this keeps the precision on
+// weak signals and avoids the saturation of the filter on the strong ones.
+// When the shift changes the memory of the filter (state and delay line)
+// is rescaled to the new shift and the input energy recomputed from it,
+// so the filter and its output never mix samples of two scales (no gain
+// steps, no clicks).
+// The instance keeps the input energy, sum of x^2 >> 15 over the taps,
+// as q15_t: with 96 taps the peak must stay below 32768 / sqrt(96) =
+// 3344 or the energy wraps negative. The peaks are kept below twice the
+// target, 3072: a louder block is scaled down at once, a weaker one
+// brought up a step per block.
+#define LMS_Q15_MIN_SHIFT   -4
+#define LMS_Q15_MAX_SHIFT   4
+#define LMS_Q15_TARGET_PEAK 0x0600
 
-  arm_copy_f32(nrbuffer, &LMS_nr_delay[lms1_inbuf], blockSize);  // put new data into the delay buffer
-  //
-  arm_lms_norm_f32(&LMS_Norm_instance, nrbuffer, &LMS_nr_delay[lms1_outbuf], nrbuffer, LMS_errsig1, blockSize);  // do noise reduction
-  //
-  //
-  lms1_inbuf += blockSize;  // bump input to the next location in our de-correlation buffer
-  lms1_outbuf = lms1_inbuf + blockSize; // advance output to same distance ahead of input
-  lms1_inbuf %= 256; // step as 2* block size
-  lms1_outbuf %= 256; // step as 2* block size
+arm_lms_norm_instance_q15  LMS_Norm_instance_q15;
+q15_t      LMS_StateQ15[MAX_LMS_TAPS + MAX_LMS_DELAY];
+q15_t      LMS_NormCoeff_q15[MAX_LMS_TAPS + MAX_LMS_DELAY];
+q15_t      LMS_nr_delay_q15[256 + MAX_LMS_DELAY];
+q15_t      LMS_errsig_q15[256 + 10];
+q15_t      LMS_out_q15[256];
+int8_t     LMS_q15_shift = 0;
+q15_t      LMS_q15_lastPeak = 0;   // peak of the last block, as filtered
+int        LMS_q15_outMode = LMS_Q15_NR;
+
+// Initialize the fixed point LMS filter, same strength scale of Init_LMS_NR
+void Init_LMS_NR_q15 (int LMS_nr_strength, int iOutMode)
+{
+  uint16_t  calc_taps = 96;
+  float32_t mu_calc;
+  q15_t     mu_q15;
+
+  // Same de-linearization of the float version
+  mu_calc = LMS_nr_strength;
+  mu_calc /= 2;
+  mu_calc += 2;
+  mu_calc /= 10;
+  mu_calc = powf(10, mu_calc);
+  mu_calc = 1 / mu_calc;
+  arm_float_to_q15(&mu_calc, &mu_q15, 1);
+
+  arm_fill_q15(0, LMS_nr_delay_q15, 256 + 128);
+  arm_fill_q15(0, LMS_StateQ15, calc_taps + 128);
+  arm_fill_q15(0, LMS_NormCoeff_q15, calc_taps);
+
+  // postShift = 0, coefficients are kept in plain q15
+  arm_lms_norm_init_q15(&LMS_Norm_instance_q15, calc_taps, &LMS_NormCoeff_q15[0], &LMS_StateQ15[0], mu_q15, 128, 0);
+
+  LMS_q15_shift = 0;
+  LMS_q15_lastPeak = 0;
+  LMS_q15_outMode = iOutMode;
 }
 
+// Peak of a q15 buffer
+static q15_t LMS_q15_peak(const q15_t *buffer, int16_t n)
+{
+  q15_t peak = 0;
+  for (int i = 0; i < n; i++) {
+    q15_t v = buffer[i];
+    if (v < 0) v = (v == INT16_MIN) ? INT16_MAX : -v;
+    if (v > peak) peak = v;
+  }
+  return peak;
+}
+
+// Evaluate the scaling to apply to this block: down at once, up one
+// step at time to avoid to disturb the adaptation of the filter, and
+// only when the previous block (the filter state and the reference) is
+// also low enough to be doubled without passing the limit
+static int8_t LMS_q15_headroom(q15_t *buffer, int16_t blockSize)
+{
+  q15_t    peak = LMS_q15_peak(buffer, blockSize);
+  int8_t   shift = LMS_q15_shift;
+
+  if (peak == 0) return shift;
+
+  // peak as it will be seen by the filter
+  int32_t scaled = (shift >= 0) ? ((int32_t)peak << shift) : ((int32_t)peak >> -shift);
+
+  if (scaled > 2 * LMS_Q15_TARGET_PEAK) {
+    while (scaled > 2 * LMS_Q15_TARGET_PEAK && shift > LMS_Q15_MIN_SHIFT) {
+      shift--;
+      scaled >>= 1;
+    }
+  } else if (scaled < LMS_Q15_TARGET_PEAK / 2 && LMS_q15_lastPeak < LMS_Q15_TARGET_PEAK &&
+             shift < LMS_Q15_MAX_SHIFT) shift++;
+
+  return shift;
+}
+
+// Input energy as the instance keeps it, from the state now in memory:
+// x0 (the sample that leaves the window next) and the last numTaps - 1
+// inputs, each term x^2 >> 15 as arm_lms_norm_q15 adds them
+static q15_t LMS_q15_energy(arm_lms_norm_instance_q15 *S)
+{
+  int32_t energy = ((int32_t)S->x0 * S->x0) >> 15;
+  for (int i = 0; i < S->numTaps - 1; i++) energy += ((int32_t)S->pState[i] * S->pState[i]) >> 15;
+  return (energy > INT16_MAX) ? INT16_MAX : energy;
+}
+
+void LMS_NoiseReduction_q15(int16_t blockSize, q15_t *nrbuffer)
+{
+  static ulong    lms1_inbuf = 0, lms1_outbuf = 0;
+  uint32_t        cycles = ARM_DWT_CYCCNT;
+
+  // new shift: bring the samples kept by the filter to the new scale,
+  // the coefficients do not depend on it
+  int8_t shift = LMS_q15_headroom(nrbuffer, blockSize);
+  if (shift != LMS_q15_shift) {
+    int8_t delta = shift - LMS_q15_shift;
+    arm_lms_norm_instance_q15 *S = &LMS_Norm_instance_q15;
+    arm_shift_q15(LMS_StateQ15, delta, LMS_StateQ15, S->numTaps + blockSize - 1);
+    arm_shift_q15(LMS_nr_delay_q15, delta, LMS_nr_delay_q15, 256 + MAX_LMS_DELAY);
+    arm_shift_q15(&S->x0, delta, &S->x0, 1);
+    // recomputed, not shifted: a shifted sum of truncated terms would
+    // drift from the terms subtracted later, until it wraps
+    S->energy = LMS_q15_energy(S);
+    LMS_q15_shift = shift;
+  }
+
+  // scale the block in the working range (arm_shift_q15 saturates)
+  if (LMS_q15_shift != 0) arm_shift_q15(nrbuffer, LMS_q15_shift, nrbuffer, blockSize);
+  LMS_q15_lastPeak = LMS_q15_peak(nrbuffer, blockSize);
+
+  arm_copy_q15(nrbuffer, &LMS_nr_delay_q15[lms1_inbuf], blockSize);  // put new data into the delay buffer
+  arm_lms_norm_q15(&LMS_Norm_instance_q15, nrbuffer, &LMS_nr_delay_q15[lms1_outbuf], LMS_out_q15, LMS_errsig_q15, blockSize);
+
+  lms1_inbuf += blockSize;
+  lms1_outbuf = lms1_inbuf + blockSize;
+  lms1_inbuf %= 256;
+  lms1_outbuf %= 256;
+
+  // back to the original level
+  q15_t *result = (LMS_q15_outMode == LMS_Q15_NOTCH) ? LMS_errsig_q15 : LMS_out_q15;
+  arm_shift_q15(result, -LMS_q15_shift, nrbuffer, blockSize);
+
+  LMS_cycles_q15 = ARM_DWT_CYCCNT - cycles;
+}
 
 #endif //RDSP_NOISE_REDUCTION_H_INCLUDED
 /**************************************END OF FILE****/
@@ -0,0 +1,202 @@
+/**
+  ******************************************************************************
+  * @file    RDSP_scheduler.h
+  * @author  Giuseppe Callipo - IK8YFW - ik8yfw@libero.it
+  * @version V1.0.0
+  * @date    19-10-2026
+  * @brief   Cooperative scheduler of the loop() tasks
+  *
+  ******************************************************************************
+  *
+  * A fixed table of tasks, run to completion from loop(). A task is due when
+  * its period has elapsed (periodic) or when its ready() says so (event
+  * driven, period 0). In a pass every due task runs once, the lowest
+  * priority number first and, at the same priority, the earliest deadline.
+  *
+  * For each task the scheduler keeps runs, run time (last, max, total), the
+  * release jitter (start - release) and the runs started after the deadline.
+  * The time out of the tasks is the idle time: Sched_Headroom() gives it as
+  * a fraction of the last window, and the idle hook is called on the passes
+  * with nothing due.
+  *
+  * The clock is a function: on the host it can be a simulated one.
+  *
+   */
+
+#ifndef RDSP_SCHEDULER_H_INCLUDED
+#define RDSP_SCHEDULER_H_INCLUDED
+
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS      8
+#define SCHED_WINDOW_MICROS  1000000   // headroom measured on this window
+
+typedef uint32_t (*SchedClock)();
+typedef void     (*SchedJob)();
+typedef bool     (*SchedReady)();
+
+struct SchedTask {
+  const char *name;
+  SchedJob    run;
+  SchedReady  ready;            // event driven: due when true (period 0)
+  uint32_t    periodMicros;     // periodic: due every period
+  uint32_t    deadlineMicros;   // from the release, 0 = none
+  uint8_t     priority;         // 0 first
+
+  uint32_t    release;          // next release (periodic)
+  bool        bRanThisPass;
+
+  uint32_t    runs;
+  uint32_t    late;             // started after release + deadline
+  uint32_t    lastMicros;
+  uint32_t    maxMicros;
+  uint64_t    totalMicros;
+  uint32_t    maxJitterMicros;  // start - release
+};
+
+SchedTask           schedTasks[SCHED_MAX_TASKS];
+int                 schedCount = 0;
+SchedClock          schedClock = 0;
+SchedJob            schedIdleHook = 0;
+
+uint32_t            schedWindowStart = 0;
+uint32_t            schedWindowBusy = 0;     // in the tasks, this window
+uint32_t            schedHeadroom = 1000;    // permille of the last window
+uint32_t            schedPasses = 0;
+uint32_t            schedIdlePasses = 0;
+
+//************************************************************************
+//      Setup
+//************************************************************************
+void Sched_Begin(SchedClock clock)
+{
+  schedClock = clock;
+  schedCount = 0;
+  schedWindowStart = schedClock();
+  schedWindowBusy = 0;
+  schedHeadroom = 1000;
+  schedPasses = 0;
+  schedIdlePasses = 0;
+}
+
+void Sched_SetIdleHook(SchedJob hook)
+{
+  schedIdleHook = hook;
+}
+
+// Returns the task index, -1 when the table is full
+int Sched_Add(const char *name, SchedJob run, uint32_t periodMicros, uint32_t deadlineMicros,
+              uint8_t priority, SchedReady ready = 0)
+{
+  if (schedCount >= SCHED_MAX_TASKS) return -1;
+
+  SchedTask &t = schedTasks[schedCount];
+  t = SchedTask();
+  t.name = name;
+  t.run = run;
+  t.ready = ready;
+  t.periodMicros = periodMicros;
+  t.deadlineMicros = deadlineMicros;
+  t.priority = priority;
+  t.release = schedClock() + periodMicros;
+  return schedCount++;
+}
+
+//************************************************************************
+//      One pass of the scheduler, from loop()
+//************************************************************************
+bool Sched_Due(SchedTask &t, uint32_t now)
+{
+  if (t.bRanThisPass) return false;
+  if (t.periodMicros == 0) return t.ready != 0 && t.ready();
+  if ((int32_t)(now - t.release) < 0) return false;
+  return t.ready == 0 || t.ready();
+}
+
+void Sched_Run()
+{
+  int ran = 0;
+
+  for (int i = 0; i < schedCount; i++) schedTasks[i].bRanThisPass = false;
+
+  for (;;) {
+    uint32_t now = schedClock();
+    int next = -1;
+
+    for (int i = 0; i < schedCount; i++) {
+      SchedTask &t = schedTasks[i];
+      if (!Sched_Due(t, now)) continue;
+      if (next < 0 || t.priority < schedTasks[next].priority) {
+        next = i;
+        continue;
+      }
+      SchedTask &n = schedTasks[next];
+      if (t.priority == n.priority && t.deadlineMicros && n.deadlineMicros &&
+          (int32_t)((t.release + t.deadlineMicros) - (n.release + n.deadlineMicros)) < 0)
+        next = i;
+    }
+    if (next < 0) break;
+
+    SchedTask &t = schedTasks[next];
+    uint32_t start = schedClock();
+    t.run();
+    uint32_t elapsed = schedClock() - start;
+
+    t.bRanThisPass = true;
+    t.runs++;
+    t.lastMicros = elapsed;
+    t.totalMicros += elapsed;
+    if (elapsed > t.maxMicros) t.maxMicros = elapsed;
+    schedWindowBusy += elapsed;
+    ran++;
+
+    if (t.periodMicros) {
+      uint32_t jitter = start - t.release;
+      if (jitter > t.maxJitterMicros) t.maxJitterMicros = jitter;
+      if (t.deadlineMicros && jitter > t.deadlineMicros) t.late++;
+      // next release on the grid; if a whole period was lost, from now
+      t.release += t.periodMicros;
+      if ((int32_t)(start - t.release) >= 0) t.release = start + t.periodMicros;
+    }
+  }
+
+  schedPasses++;
+  if (ran == 0) {
+    schedIdlePasses++;
+    if (schedIdleHook) schedIdleHook();
+  }
+
+  uint32_t now = schedClock();
+  uint32_t window = now - schedWindowStart;
+  if (window >= SCHED_WINDOW_MICROS) {
+    uint32_t busy = schedWindowBusy < window ? schedWindowBusy : window;
+    schedHeadroom = (uint64_t)(window - busy) * 1000 / window;
+    schedWindowStart = now;
+    schedWindowBusy = 0;
+  }
+}
+
+// Idle time of the last window, permille
+uint32_t Sched_Headroom()
+{
+  return schedHeadroom;
+}
+
+#ifdef ARDUINO
+// Scheduler statistics, CAT debug page 0 (DB0;)
+void Sched_Report(Print &out)
+{
+  out.printf("sched headroom %lu.%lu%%  passes %lu  idle %lu\n",
+             schedHeadroom / 10, schedHeadroom % 10, schedPasses, schedIdlePasses);
+  for (int i = 0; i < schedCount; i++) {
+    SchedTask &t = schedTasks[i];
+    out.printf("%-10s runs %8lu  avg %5lu us  max %5lu us  jitter %6lu us  late %6lu\n",
+               t.name, t.runs, t.runs ? (uint32_t)(t.totalMicros / t.runs) : 0,
+               t.maxMicros, t.maxJitterMicros, t.late);
+  }
+}
+#endif
+
+#endif /* RDSP_SCHEDULER_H_INCLUDED */
+
+/**************************************END OF FILE****/
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file    RDSP_spectrum_smooth.h
+  * @author  Giuseppe Callipo - IK8YFW - ik8yfw@libero.it
+  * @version V1.0.0
+  * @date    19-10-2026
+  * @brief   Panadapter spectrum smoothing, q15 SIMD kernel
+  *
+  ******************************************************************************
+  *
+  * No hardware access: on the host the dspinst.h intrinsics come from a
+  * stub in plain C and the kernel is checked against a float reference
+  * (test/host).
+  *
+   */
+
+#ifndef RDSP_SPECTRUM_SMOOTH_H_INCLUDED
+#define RDSP_SPECTRUM_SMOOTH_H_INCLUDED
+
+#include <stdint.h>
+#include "utility/dspinst.h"
+
+//************************************************************************
+//       Spectrum smoothing kernel on the analyzer dB q8.8 output
+//************************************************************************
+// Frequency: 5 taps symmetric FIR, weights center/x+-1/x+-2 in q15.
+// Time: one pole IIR made with a shift, out += (fir - out) >> shift.
+// Two bins per step from three words of the input: the sums of the
+// symmetric taps are made with one SIMD halving add (no overflow of the
+// 16 bit lanes) and weighted with one dual multiply, the side weights
+// are doubled to make up for the halving.
+uint32_t smoothSideCoef = 0;     // top 2*w1, bottom 2*w2 (q15)
+int32_t  smoothCenterCoef = 0;   // w0 (q15)
+int      smoothTimeShift = 1;    // 0 = no time smoothing
+
+// Weights as integer ratios, normalized to unity gain: 14,6,3 is the
+// shape of the original 0.7 / 0.3 / 0.15 (that summed to 1.6)
+void setSpectrumSmoothing(int w0, int w1, int w2, int timeShift)
+{
+  int32_t total = w0 + 2 * w1 + 2 * w2;
+  if (w0 < 0 || w1 < 0 || w2 < 0 || total <= 0) {
+    w0 = 1; w1 = 0; w2 = 0; total = 1;
+  }
+  int32_t c1 = (w1 * 32768) / total;
+  int32_t c2 = (w2 * 32768) / total;
+  if (c1 > 16383) c1 = 16383;
+  if (c2 > 16383) c2 = 16383;
+
+  // the center takes the rest, unity gain on a flat spectrum
+  smoothCenterCoef = 32768 - 2 * c1 - 2 * c2;
+  smoothSideCoef = pack_16b_16b(2 * c1, 2 * c2);
+  smoothTimeShift = (timeShift < 0) ? 0 : (timeShift > 8) ? 8 : timeShift;
+}
+
+// in: analyzer frame (4 bytes aligned, values below 32768), n even
+// out: smoothed spectrum, updated in place. The first and the last two
+// bins are not filtered in frequency.
+void smoothSpectrum_q15(const uint16_t *in, int16_t *out, int n)
+{
+  const uint32_t *src = (const uint32_t *)in;
+  uint32_t coef = smoothSideCoef;
+  int32_t  c0 = smoothCenterCoef;
+  int      k = smoothTimeShift;
+
+  out[0] += ((int16_t)in[0] - out[0]) >> k;
+  out[1] += ((int16_t)in[1] - out[1]) >> k;
+
+  uint32_t w0 = src[0];   // x[i-2], x[i-1]
+  uint32_t w1 = src[1];   // x[i],   x[i+1]
+  for (int i = 2; i < n - 2; i += 2)
+  {
+    uint32_t w2 = src[(i >> 1) + 1];   // x[i+2], x[i+3]
+
+    // bin i: (x[i-2] + x[i+2]) / 2 bottom, (x[i-1] + x[i+1]) / 2 top
+    uint32_t sum = signed_halving_add_16_and_16(w0, pack_16t_16b(w1, w2));
+    int32_t y0 = (multiply_16tx16t_add_16bx16b(sum, coef) + c0 * (int16_t)w1) >> 15;
+
+    // bin i+1: (x[i-1] + x[i+3]) / 2 bottom, (x[i] + x[i+2]) / 2 top
+    sum = signed_halving_add_16_and_16(pack_16b_16b(w1, w0 >> 16),
+                                       pack_16b_16b(w2, w2 >> 16));
+    int32_t y1 = (multiply_16tx16t_add_16bx16b(sum, coef) + c0 * (int16_t)(w1 >> 16)) >> 15;
+
+    out[i]     += (y0 - out[i]) >> k;
+    out[i + 1] += (y1 - out[i + 1]) >> k;
+
+    w0 = w1;
+    w1 = w2;
+  }
+
+  out[n - 2] += ((int16_t)in[n - 2] - out[n - 2]) >> k;
+  out[n - 1] += ((int16_t)in[n - 1] - out[n - 1]) >> k;
+}
+
+#endif /* RDSP_SPECTRUM_SMOOTH_H_INCLUDED */
+
+/**************************************END OF FILE****/
@@ -33,6 +33,8 @@
 #include "RDSP_display.h"
 #include "RDSP_noise_reduction.h"
 #include "RDSP_convolutional.h"
+#include "RDSP_scheduler.h"
+#include "RDSP_cat.h"
 
 //************************************************************************
 // Enanched ILI9341 display driver
@@ -54,10 +56,9 @@ AudioSDRpreProcessor   preProcessor;
 AudioSDR               SDR;
 AudioOutputI2S         audio_out;
 AudioControlSGTL5000   codec;
-AudioAnalyzeFFT256IQ   FFT;
-AudioAnalyzeFFT1024     AudioFFT;
-AudioFilterBiquad      biquad1;
-AudioFilterBiquad      biquad2;
+PanadapterFFT          FFT;
+AudioAnalyzeFFTIQ<PANADAPTER_ZOOM_SIZE> ZoomFFT;
+AudioAnalyzeFFT1024Sync AudioFFT;
 
 //************************************************************************
 // Audio components for the convolutional blocks
@@ -71,11 +72,11 @@ AudioPlayQueue           Q_out_R;
 AudioConnection c1(IQinput, 0, preProcessor, 0);
 AudioConnection c2(IQinput, 1, preProcessor, 1);
 
-// Spectrum RF analisys
-AudioConnection c2f1(IQinput, 0, biquad1, 0);  
-AudioConnection c2f2(IQinput, 1, biquad2, 0);  
-AudioConnection c2f11(biquad1, 0, FFT, 0);  
-AudioConnection c2f22(biquad2, 0, FFT, 1);  
+// Spectrum RF analisys (DC removed inside the analyzer)
+AudioConnection c2f1(IQinput, 0, FFT, 0);  
+AudioConnection c2f2(IQinput, 1, FFT, 1);  
+AudioConnection c2f3(IQinput, 0, ZoomFFT, 0);
+AudioConnection c2f4(IQinput, 1, ZoomFFT, 1);
 
 // SDR path 
 AudioConnection a3(preProcessor, 0, SDR, 0);
@@ -89,9 +90,114 @@ AudioConnection c7(Q_out_L, 0, audio_out, 0);
 AudioConnection c8(Q_out_R, 0, audio_out, 1);
 
 //**************************************************************************
-// Timer management
-Metro tuner = Metro(50);
-Metro commands = Metro(200);
+// Tasks of the loop, run by the scheduler (RDSP_scheduler.h)
+void Task_DSP()
+{
+  // Analyzer work moved out of the audio interrupt
+  fftiqWorkQueue().runDeferred();
+
+  // Execute convolutional processing block
+  if (bBypassMode) doBypassProcessing(nr_level, iBypassLMSMode);
+  else doConvolutionalProcessing(nr_level, true, 300.0, 4000.0);
+}
+
+bool Task_DSPReady()
+{
+  return audioBacklog() || fftiqWorkQueue().pending();
+}
+
+void Task_Input()
+{
+  // Button events from the input sampler
+  checkCmd();
+}
+
+void Task_CAT()
+{
+  // Commands from the USB serial
+  Cat_Poll();
+}
+
+void Task_Tuning()
+{
+  // the knob is sampled at 1 kHz by the input timer
+  setFreq();
+}
+
+void Task_Render()
+{
+  // Display widgets, as much as fits in the time budget of a pass
+  Render_Run(audioBacklog());
+
+  // Send the changed parts of the frame buffer to the panel
+  Update_Display();
+}
+
+void Task_Telemetry()
+{
+  heapCheck();
+}
+
+// Nothing due: the core sleeps until the next interrupt (audio block,
+// input timer, USB, systick every millisecond). An event that comes just
+// before the sleep waits at most for the next systick.
+void Task_Idle()
+{
+  asm volatile ("wfi");
+}
+
+// Statistics pages, asked with the CAT debug command DBn; (the serial
+// carries the CAT, nothing is printed unasked)
+bool Telemetry_Report(int page, Print &out)
+{
+  switch (page) {
+    case 0:
+      Sched_Report(out);
+      out.printf("cat commands %lu  errors %lu  dropped %lu  report lost %lu\n",
+                 catCommands, catErrors, catDropped, catReport.lost);
+      out.printf("heap at setup %d  delta %d  changes %lu\n", heapAtSetup, heapDelta, heapChanges);
+      return true;
+    case 1:
+      Render_Report(out);
+      return true;
+    case 2:
+      Vfo_Report(out);
+      return true;
+    case 3:
+      out.printf("lms f32 %lu cycles  q15 %lu cycles (last block of each)\n",
+                 LMS_cycles_f32, LMS_cycles_q15);
+#if defined(PANADAPTER_FFT_SIZE)
+      out.printf("panadapter q15 %d: fft %lu cycles (max %lu), %lu ffts, %.2f%% cpu, %.1f Hz/bin\n",
+                 PANADAPTER_FFT_SIZE, FFT.cyclesPerFFT(), FFT.cyclesPerFFTMax(), FFT.fftsDone(),
+                 FFT.cpuLoad(), FFT.binWidth());
+#elif defined(PANADAPTER_FLOAT_FFT)
+      out.printf("panadapter f32 256: fft %lu cycles in loop, isr %lu cycles, queue dropped %lu\n",
+                 FFT.cyclesPerFFT(), FFT.isrCycles(), fftiqWorkQueue().droppedJobs());
+#else
+      out.printf("panadapter q15 256: fft %lu cycles, isr %lu cycles, filter bank %lu cycles\n",
+                 FFT.cyclesPerFFT(), FFT.isrCycles(), FFT.polyphaseCycles());
+#endif
+      out.printf("zoom q15 %d x%d %s: fft %lu cycles (max %lu), %lu ffts, %.2f%% cpu, %.1f Hz/bin\n",
+                 PANADAPTER_ZOOM_SIZE, ZoomFFT.zoom(), ZoomFFT.isEnabled() ? "on" : "off",
+                 ZoomFFT.cyclesPerFFT(), ZoomFFT.cyclesPerFFTMax(),
+                 ZoomFFT.fftsDone(), ZoomFFT.cpuLoad(), ZoomFFT.binWidth());
+      return true;
+  }
+  return false;
+}
+
+void initTasks()
+{
+  Sched_Begin(micros);
+  //       name         task            period  deadline  prio
+  Sched_Add("dsp",       Task_DSP,            0,        0,   0, Task_DSPReady);
+  Sched_Add("input",     Task_Input,       5000,     5000,   1);
+  Sched_Add("tuning",    Task_Tuning,     20000,    10000,   1);
+  Sched_Add("cat",       Task_CAT,            0,        0,   1, Cat_Ready);
+  Sched_Add("render",    Task_Render,      5000,    20000,   2);
+  Sched_Add("telemetry", Task_Telemetry, 200000,   200000,   3);
+  Sched_SetIdleHook(Task_Idle);
+}
 //**************************************************************************
 
 //************************************************************************
@@ -109,9 +215,8 @@ void setup()
   tuningMode();
   MENU_displayMenuLevel();
   
-  pinMode(BUTTON_D2, INPUT_PULLUP);
-  pinMode(BUTTON_D3, INPUT_PULLUP);
-  pinMode(BUTTON_D6, INPUT_PULLUP);
+  // Buttons sampled by a timer, events to checkCmd()
+  initInput();
   delay (500);
 
   preProcessor.startAutoI2SerrorDetection();    // IQ error compensation
@@ -119,11 +224,11 @@ void setup()
 
   SDR.enableAGC();                
   SDR.setAGCmode(AGCmedium);
-  newAgc= "AGC M";
+  newAgc= AGC_LABELS[2];
   showAgcMode();
   
   SDR.disableALSfilter();
-  newNR= "";
+  newNR= NR_LABELS[0];
   showNRMode();
  
   //SDR.enableNoiseBlanker();             // You can choose whether this is necessary
@@ -132,17 +237,43 @@ void setup()
  
   SDR.setInputGain(1.0);                  // You mave have to experiment with these
   SDR.setOutputGain(0.5);
-  SDR.setIQgainBalance(1.020);            // This was foumd by experimentation
+  SDR.setIQgainBalance(IQ_GAIN_BALANCE);  // This was foumd by experimentation
  
   SDR.enableAudioFilter();
   SDR.setAudioFilter(audio2700);
   TuningOffset = SDR.setDemodMode(LSBmode);  
-  newFilter= "2.7 kHz";
+  newFilter= FILTER_LABELS[2];
   fndx=2;
   showFilter();
 
+#ifdef PANADAPTER_FFT_SIZE
+  FFT.windowFunction(FFTIQ_WINDOW_HANNING);
+  FFT.setOverlap(FFTIQ_OVERLAP_50);
+#else
   FFT.windowFunction(AudioWindowHanning256);
-  FFT.averageTogether(30);
+#endif
+#if defined(PANADAPTER_POLYPHASE) && !defined(PANADAPTER_FLOAT_FFT) && !defined(PANADAPTER_FFT_SIZE)
+  FFT.polyphase(true);
+#endif
+  FFT.averageMode(FFTIQ_AVG_EXP, 4);   // ~16 spectra, a new frame every block
+  FFT.outputDb(true);
+  FFT.dcRemoval(true);
+#ifdef PANADAPTER_IQ_GAIN
+  FFT.iqCorrection(true, PANADAPTER_IQ_GAIN);
+#endif
+
+  // decimating around the carrier, the offset follows TuningOffset
+  // (Pan_FollowTuning), running only in the zoom scope
+  ZoomFFT.windowFunction(FFTIQ_WINDOW_HANNING);
+  ZoomFFT.setOverlap(FFTIQ_OVERLAP_50);
+  ZoomFFT.averageMode(FFTIQ_AVG_EXP, 2);  // ~21 spectra/s, 4 averaged
+  ZoomFFT.outputDb(true);
+  ZoomFFT.dcRemoval(true);
+#ifdef PANADAPTER_IQ_GAIN
+  ZoomFFT.iqCorrection(true, PANADAPTER_IQ_GAIN);
+#endif
+  ZoomFFT.setZoom(PANADAPTER_ZOOM, TuningOffset);
+  ZoomFFT.enable(nscope == 3);            // setScopeMode() switches it
   
   AudioFFT.windowFunction(AudioWindowHanning1024);
   AudioFFT.averageTogether(30);
@@ -150,10 +281,6 @@ void setup()
   // Set up the Audio board
   AudioMemory(40);
   AudioNoInterrupts();
-
-  // Filter for DC cleaning before FFT Panadapter
-  biquad1.setHighpass(0,500,0.5);
-  biquad2.setHighpass(0,500,0.5);
   
   // Place the enable as first operation ...
   codec.enable();
@@ -184,6 +311,13 @@ void setup()
   showPBT();
  
   delay(500);
+
+  Serial.begin(115200);   // USB: the baud rate is not used
+  initCat(Serial);
+  initTasks();
+
+  // from here on the heap use must not change
+  heapMark();
 }
 
 //************************************************************************
@@ -194,40 +328,6 @@ void setup()
 
 void loop()
 {
-   // Execute convolutional processing block
-  doConvolutionalProcessing(nr_level, true, 300.0, 4000.0);
-  
-  if (commands.check() == 1)
-  {
-    checkCmd();
-  }
-  if (tuner.check() == 1)
-  {
-    setFreq();
-  }
- 
-  if (iMode != MENU_MODE) {
-    timeSpc = millis();
-    if ((timeSpc - lastTimeSpc) > intervalSpc){
-      if (FFT.available()) { 
-        
-        // Is the Full Panadapter active ?
-        if (nscope ==0) Update_Panadapter(0);
-
-        // Update meter
-        Update_smeter();
-     } 
-
-     // Is the AudioScope Active
-     if (AudioFFT.available() && nscope ==1) {
-      
-        //Update_AudioSpectrum();
-        Update_DoubleSpectrum();
-     }
-      lastTimeSpc = timeSpc;
-    }
-  }
-
- 
-  
- }
+  // Every due task once: DSP first, then input and tuning, render, telemetry
+  Sched_Run();
+}
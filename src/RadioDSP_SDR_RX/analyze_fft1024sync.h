@@ -0,0 +1,73 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef analyze_fft1024sync_h_
+#define analyze_fft1024sync_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "analyze_fft1024.h"
+#include "analyze_fftiq_common.h"
+
+// AudioAnalyzeFFT1024 with the frame protocol of AudioAnalyzeFFT256IQ:
+// after the library update the new output[] is copied in the back
+// buffer inside the ISR, so loop() never reads a half written spectrum.
+class AudioAnalyzeFFT1024Sync : public AudioAnalyzeFFT1024
+{
+public:
+  virtual void update(void) {
+    AudioAnalyzeFFT1024::update();
+    if (AudioAnalyzeFFT1024::available()) {
+      uint16_t *dst = frames.beginWrite();
+      if (!dst) return;
+      memcpy(dst, output, sizeof(output));
+      frames.commit();
+    }
+  }
+
+  bool available() {
+    return frames.available();
+  }
+
+  // 512 bins, stable until unlockFrame()
+  const uint16_t *lockFrame() {
+    return frames.lock();
+  }
+
+  void unlockFrame() {
+    frames.unlock();
+  }
+
+  uint32_t frameSequence() {
+    return frames.sequence();
+  }
+
+private:
+  FFTIQFrames<512> frames;
+};
+
+#endif
@@ -28,91 +28,189 @@
 #include "analyze_fft256iq.h"
 #include "utility/sqrt_integer.h"
 #include "utility/dspinst.h"
+#include "analyze_fft256iq_kernels.h"
 
 //#include "analyze_fft256iq.h"
 //#include "utility/sqrt_integer.h"
 //#include "utility/dspinst.h"
 
 
-// 140312 - PAH - slightly faster copy
-static void copy_to_fft_buffer(void *destination, const void *source1, const void *source2)
+// convert the averaged spectrum to the output format, DC in the middle
+void AudioAnalyzeFFT256IQ::publish(void)
 {
-  const uint16_t *src1 = (const uint16_t *)source1;
-        const uint16_t *src2 = (const uint16_t *)source2;
-  uint32_t *dst = (uint32_t *)destination;
+  uint16_t *output = frames.beginWrite();
+  if (!output) return;   // loop() still reads the other frame
 
-  for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
-    
-                *dst++ = *src1++ | ((*src2++) <<16); 
+  if (outputdb) {
+    for (int i = 0; i < 256; i++) {
+      output[255 - (i ^ 128)] = fftiq_magsq_to_db_q88(sum[i], dboffset);
+    }
+  } else {
+    for (int i = 0; i < 256; i++) {
+      output[255 - (i ^ 128)] = sqrt_uint32_approx(sum[i]);
+    }
   }
+  frames.commit();
 }
 
-static void apply_window_to_fft_buffer(void *buffer, const void *window)
+void AudioAnalyzeFFT256IQ::polyphase(bool enable)
 {
-  int16_t *buf = (int16_t *)buffer;
-  const int16_t *win = (int16_t *)window;;
-
-  for (int i=0; i < 256; i++) {
-
-                buf[0] = (buf[0] * *win) >> 15;
-                buf[1] = (buf[1] * *win) >> 15;
-    buf += 2;
-                win++;
+  if (enable) {
+    // windowed sinc over 4 FFT lengths (Blackman-Harris), 1.3 bins
+    // wide: the near bins cross at -3 dB, a tone between two bins reads
+    // 3 dB low (6 dB with a sinc one bin wide)
+    const int L = 4 * 256;
+    const float width = 1.3;
+    for (int n = 0; n < L; n++) {
+      float x = (n - 0.5 * (L - 1)) / 256.0 * width;
+      float h = (fabsf(x) < 1e-6) ? 1.0 : sinf(PI * x) / (PI * x);
+      float a = 2.0 * PI * n / (L - 1);
+      h *= 0.35875 - 0.48829 * cosf(a) + 0.14128 * cosf(2 * a) - 0.01168 * cosf(3 * a);
+      pfbcoef[n] = (int16_t)(h * 32767.0);
+    }
   }
-
+  __disable_irq();
+  pfb = enable;
+  pfbfilled = 0;
+  pfbhead = 0;
+  __enable_irq();
 }
 
-void AudioAnalyzeFFT256IQ::update(void)
+// Weighted overlap-add of the last 1024 samples in the 256 FFT inputs:
+// x[n] = sum(k = 0..3) h[n + 256k] * s[n + 256k]
+void AudioAnalyzeFFT256IQ::polyphaseFrame(void)
 {
-  audio_block_t *block_i,*block_q;
-
-  
-        block_i=receiveReadOnly(0); 
-        block_q=receiveReadOnly(1);     
-  if (!block_i || !block_q ) return;
-  if (!prevblock_i || !prevblock_q) {
-    prevblock_i = block_i;
-                prevblock_q = block_q;
-    return;
+  uint32_t start = ARM_DWT_CYCCNT;
+  uint32_t *dst = (uint32_t *)buffer;
+
+  for (int n = 0; n < 256; n++) {
+    int32_t acci = 0, accq = 0;
+    for (int k = 0; k < 4; k++) {
+      uint16_t m = n + 256 * k;
+      uint32_t iq = pfbring[(pfbhead + m) & 1023];
+      uint32_t c = (uint16_t)pfbcoef[m];
+      acci += multiply_16bx16b(iq, c);
+      accq += multiply_16tx16b(iq, c);
+    }
+    *dst++ = pack_16b_16b(signed_saturate_rshift(accq, 16, 15), signed_saturate_rshift(acci, 16, 15));
   }
-  copy_to_fft_buffer(buffer, prevblock_i->data,prevblock_q->data);
-  copy_to_fft_buffer(buffer+256, block_i->data,block_q->data);
-  
-  if (window) apply_window_to_fft_buffer(buffer, window);
-  arm_cfft_radix4_q15(&fft_inst, buffer);
+  pfbcycles = ARM_DWT_CYCCNT - start;
+}
 
+// average the new spectrum with the selected engine and publish it
+void AudioAnalyzeFFT256IQ::accumulate(void)
+{
   // G. Heinzel's paper says we're supposed to average the magnitude
   // squared, then do the square root at the end.
-  if (count == 0) {
+  uint32_t *bins = (uint32_t *)buffer;
+  if (avgmode == FFTIQ_AVG_BLOCK) {
+    if (count == 0) {
+      for (int i=0; i < 256; i++) {
+        uint32_t tmp = bins[i];
+        uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+        sum[i] = magsq / naverage;
+      }
+    } else {
+      for (int i=0; i < 256; i++) {
+        uint32_t tmp = bins[i];
+        uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+        sum[i] += magsq / naverage;
+      }
+    }
+    if (++count == naverage) {
+      count = 0;
+      publish();
+    }
+  } else if (avgmode == FFTIQ_AVG_LINEAR) {
+    // running sum over the history ring, the oldest spectrum leaves it
+    uint32_t *slot = linhist[linidx];
     for (int i=0; i < 256; i++) {
-      uint32_t tmp = *((uint32_t *)buffer + i);
-      uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
-      sum[i] = magsq / naverage;
+      uint32_t tmp = bins[i];
+      uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp) >> avgparam;
+      if (count == 0) sum[i] = 0;
+      sum[i] += magsq - ((count == 0) ? 0 : slot[i]);
+      slot[i] = magsq;
     }
+    if (count == 0) {
+      for (int h = 1; h < (1 << avgparam); h++) memset(linhist[h], 0, sizeof(linhist[h]));
+      count = 1;
+    }
+    linidx = (linidx + 1) & ((1 << avgparam) - 1);
+    publish();
   } else {
     for (int i=0; i < 256; i++) {
-      uint32_t tmp = *((uint32_t *)buffer + i);
+      uint32_t tmp = bins[i];
       uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
-      sum[i] += magsq / naverage;
+      sum[i] = (count == 0) ? magsq : fftiq_average_step(avgmode, avgparam, sum[i], magsq);
     }
+    count = 1;
+    publish();
   }
-  if (++count == naverage) {
-    count = 0;
-
+}
 
+void AudioAnalyzeFFT256IQ::update(void)
+{
+  audio_block_t *block_i,*block_q;
+  uint32_t start = ARM_DWT_CYCCNT;
 
+  block_i=receiveReadOnly(0);
+  block_q=receiveReadOnly(1);
+  if (!block_i || !block_q ) {
+    if (block_i) release(block_i);
+    if (block_q) release(block_q);
+    return;
+  }
 
+  // the input is copied (and conditioned) once, the audio blocks are released at once
+  cur ^= 1;
+  int16_t *cur_i = blocks[cur][0], *cur_q = blocks[cur][1];
+  int16_t *prev_i = blocks[cur ^ 1][0], *prev_q = blocks[cur ^ 1][1];
+  if (conditioner.active()) {
+    conditioner.process(block_i->data, block_q->data, cur_i, cur_q, AUDIO_BLOCK_SAMPLES);
+  } else {
+    memcpy(cur_i, block_i->data, sizeof(blocks[0][0]));
+    memcpy(cur_q, block_q->data, sizeof(blocks[0][1]));
+  }
+  release(block_i);
+  release(block_q);
 
-    for (int i = 0; i < 256; i++) {
-      output[255 - (i ^ 128)] = sqrt_uint32_approx(sum[i]);
+  if (!haveprev) {
+    haveprev = true;
+    return;
+  }
+  uint32_t fftstart = ARM_DWT_CYCCNT;
+  if (pfb) {
+    // the newest block goes in the ring, pfbhead is then the oldest sample
+    copy_to_fft_buffer(&pfbring[pfbhead], cur_i, cur_q);
+    pfbhead = (pfbhead + AUDIO_BLOCK_SAMPLES) & 1023;
+    if (pfbfilled < 4 * 256) pfbfilled += AUDIO_BLOCK_SAMPLES;
+    if (pfbfilled == 4 * 256) {
+      polyphaseFrame();
+      arm_cfft_radix4_q15(&fft_inst, buffer);
+      accumulate();
+      cycles = ARM_DWT_CYCCNT - fftstart;
     }
+    isrcycles = ARM_DWT_CYCCNT - start;
+    return;
+  }
 
-
-
-    outputflag = true;
+  if (window) {
+    copy_window_to_fft_buffer(buffer, prev_i, prev_q, window);
+    copy_window_to_fft_buffer(buffer+256, cur_i, cur_q, window+AUDIO_BLOCK_SAMPLES);
+#ifdef FFT256IQ_VERIFY_KERNEL
+    // check the fused kernel against the original two pass code
+    static int16_t reference[512] __attribute__ ((aligned (4)));
+    copy_to_fft_buffer(reference, prev_i, prev_q);
+    copy_to_fft_buffer(reference+256, cur_i, cur_q);
+    apply_window_to_fft_buffer(reference, window);
+    if (memcmp(reference, buffer, sizeof(buffer)) != 0) kernelMismatch++;
+#endif
+  } else {
+    copy_to_fft_buffer(buffer, prev_i, prev_q);
+    copy_to_fft_buffer(buffer+256, cur_i, cur_q);
   }
-  release(prevblock_i);
-        release(prevblock_q);
-  prevblock_i = block_i;
-        prevblock_q = block_q;
+  arm_cfft_radix4_q15(&fft_inst, buffer);
+  accumulate();
+  cycles = ARM_DWT_CYCCNT - fftstart;
+  isrcycles = ARM_DWT_CYCCNT - start;
 }
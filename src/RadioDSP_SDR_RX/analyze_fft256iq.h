@@ -33,6 +33,7 @@
 #include "Arduino.h"
 #include "AudioStream.h"
 #include "arm_math.h"
+#include "analyze_fftiq_common.h"
 
 // windows.c
 extern "C" {
@@ -53,22 +54,35 @@ class AudioAnalyzeFFT256IQ : public AudioStream
 {
 public:
   AudioAnalyzeFFT256IQ() : AudioStream(2, inputQueueArray),
-    window(AudioWindowBlackmanNuttall256), prevblock_i(NULL), prevblock_q(NULL),count(0),
-    naverage(8), outputflag(false) {
+    window(AudioWindowBlackmanNuttall256), cur(0), haveprev(false), count(0),
+    naverage(8), outputdb(false), dboffset(0),
+    avgmode(FFTIQ_AVG_BLOCK), avgparam(0), linidx(0),
+    pfb(false), pfbhead(0), pfbfilled(0), pfbcycles(0), cycles(0), isrcycles(0) {
     arm_cfft_radix4_init_q15(&fft_inst, 256, 0, 1);
   }
 
+  // a new frame was published since the last lockFrame()
   bool available() {
-    if (outputflag == true) {
-      outputflag = false;
-      return true;
-    }
-    return false;
+    return frames.available();
+  }
+
+  // Latest frame, output[256] with DC in the middle. The pointer is
+  // stable until unlockFrame(), the ISR does not touch it meanwhile.
+  const uint16_t *lockFrame() {
+    return frames.lock();
+  }
+
+  void unlockFrame() {
+    frames.unlock();
+  }
+
+  uint32_t frameSequence() {
+    return frames.sequence();
   }
 
   float read(unsigned int binNumber) {
     if (binNumber > 255) return 0.0;
-    return (float)(output[binNumber]) * (1.0 / 16384.0);
+    return (float)(frames.latest()[binNumber]) * (1.0 / 16384.0);
   }
 
   float read(unsigned int binFirst, unsigned int binLast) {
@@ -79,6 +93,7 @@ public:
     }
     if (binFirst > 255) return 0.0;
     if (binLast > 255) binLast = 255;
+    const uint16_t *output = frames.latest();
     uint32_t sum = 0;
     do {
       sum += output[binFirst++];
@@ -89,22 +104,92 @@ public:
   void averageTogether(uint8_t n) {
     if (n == 0) n = 1;
     naverage = n;
+    avgmode = FFTIQ_AVG_BLOCK;
+  }
+
+  // Select one of the FFTIQ_AVG_xxx engines, param is the shift (see
+  // analyze_fftiq_common.h). The first spectrum restarts the average.
+  void averageMode(uint8_t mode, uint8_t param) {
+    param = fftiq_average_param(mode, param);
+    __disable_irq();
+    avgmode = mode;
+    avgparam = param;
+    count = 0;
+    linidx = 0;
+    __enable_irq();
   }
 
   void windowFunction(const int16_t *w) {
     window = w;
   }
 
+  // When enabled output[] holds 10*log10(|X|^2) + offset in dB q8.8
+  // (1 LSB of magnitude squared = 0 dB) instead of the linear magnitude
+  void outputDb(bool enable, int16_t offset_q88 = 0) {
+    outputdb = enable;
+    dboffset = offset_q88;
+  }
+
+  // Polyphase filter bank: each bin gets a 4 x 256 taps prototype
+  // filter instead of the 256 points window, the bins are almost
+  // rectangular and a strong station does not spread its skirts on
+  // the near columns. Costs one more MAC pass (1024 per spectrum).
+  void polyphase(bool enable);
+
+  // DC tracker and IQ imbalance correction on the input, see
+  // FFTIQConditioner: no high pass filters are needed before the analyzer
+  void dcRemoval(bool enable, uint8_t shift = FFTIQ_DC_SHIFT_DEFAULT) {
+    conditioner.dcRemoval(enable, shift);
+  }
+
+  void iqCorrection(bool enable, float gain = 1.0, float phase = 0.0) {
+    conditioner.iqCorrection(enable, gain, phase);
+  }
+
+  // cycles of the last filter bank pass
+  uint32_t polyphaseCycles() { return pfbcycles; }
+
+  // cycles of the last spectrum (window or filter bank, FFT, average)
+  // and of the whole last update(), all in the audio interrupt: the
+  // same counters of AudioAnalyzeFFT256IQF to compare the two
+  uint32_t cyclesPerFFT() { return cycles; }
+  uint32_t isrCycles() { return isrcycles; }
+
   virtual void update(void);
-  uint16_t output[256] __attribute__ ((aligned (4)));
+
+#ifdef FFT256IQ_VERIFY_KERNEL
+  // blocks where the fused copy+window differs from the reference code
+  uint32_t kernelMismatch = 0;
+#endif
 private:
+  void publish(void);
+
   const int16_t *window;
-  audio_block_t *prevblock_i,*prevblock_q;
+  // conditioned copies of the last two blocks, cur is the newest
+  int16_t blocks[2][2][AUDIO_BLOCK_SAMPLES] __attribute__ ((aligned (4)));
+  uint8_t cur;
+  bool haveprev;
+  FFTIQConditioner conditioner;
   int16_t buffer[512] __attribute__ ((aligned (4)));
   uint32_t sum[256];
   uint8_t count;
   uint8_t naverage;
-  volatile bool outputflag;
+  FFTIQFrames<256> frames;
+  bool outputdb;
+  int16_t dboffset;
+  uint8_t avgmode;
+  uint8_t avgparam;
+  uint8_t linidx;
+  uint32_t linhist[1 << FFTIQ_LINEAR_MAX_SHIFT][256];
+  void polyphaseFrame(void);
+  void accumulate(void);
+  bool pfb;
+  uint16_t pfbhead;
+  uint16_t pfbfilled;
+  uint32_t pfbcycles;
+  uint32_t cycles, isrcycles;
+  uint32_t pfbring[4 * 256];        // packed I | Q << 16, last 1024 samples
+  int16_t pfbcoef[4 * 256];
   audio_block_t *inputQueueArray[2];
   arm_cfft_radix4_instance_q15 fft_inst;
 };
@@ -0,0 +1,69 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Copy and window kernels of AudioAnalyzeFFT256IQ, in a header of their
+ * own: they use only the dspinst.h intrinsics, so on the host they are
+ * built with a C stub of them and checked against each other (test/host).
+ * AUDIO_BLOCK_SAMPLES and the intrinsics come from the includer.
+ *
+ * Same license as analyze_fft256iq.cpp.
+ */
+
+#ifndef analyze_fft256iq_kernels_h_
+#define analyze_fft256iq_kernels_h_
+
+#include <stdint.h>
+
+// 140312 - PAH - slightly faster copy
+static void copy_to_fft_buffer(void *destination, const void *source1, const void *source2)
+{
+  const uint16_t *src1 = (const uint16_t *)source1;
+        const uint16_t *src2 = (const uint16_t *)source2;
+  uint32_t *dst = (uint32_t *)destination;
+
+  for (int i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+    
+                *dst++ = *src1++ | ((*src2++) <<16); 
+  }
+}
+
+static void apply_window_to_fft_buffer(void *buffer, const void *window)
+{
+  int16_t *buf = (int16_t *)buffer;
+  const int16_t *win = (int16_t *)window;;
+
+  for (int i=0; i < 256; i++) {
+
+                buf[0] = (buf[0] * *win) >> 15;
+                buf[1] = (buf[1] * *win) >> 15;
+    buf += 2;
+                win++;
+  }
+
+}
+
+// Fused interleave + window of one block (128 complex samples) straight
+// into the FFT buffer, two samples per step. With the I and Q words
+// holding two samples each, the products are:
+//   I0*w0 = smulbb(ii, ww)   Q0*w0 = smulbb(qq, ww)
+//   I1*w1 = smultt(ii, ww)   Q1*w1 = smultt(qq, ww)
+// and pkhbt keeps the low half word of each >> 15, exactly as the
+// int16_t store of apply_window_to_fft_buffer() does.
+static void copy_window_to_fft_buffer(void *destination, const void *source1,
+                                      const void *source2, const void *window)
+{
+  const uint32_t *src1 = (const uint32_t *)source1;
+  const uint32_t *src2 = (const uint32_t *)source2;
+  const uint32_t *win = (const uint32_t *)window;
+  uint32_t *dst = (uint32_t *)destination;
+
+  for (int i=0; i < AUDIO_BLOCK_SAMPLES / 2; i++) {
+    uint32_t ii = *src1++;
+    uint32_t qq = *src2++;
+    uint32_t ww = *win++;
+    *dst++ = pack_16b_16b(multiply_16bx16b(qq, ww) >> 15, multiply_16bx16b(ii, ww) >> 15);
+    *dst++ = pack_16b_16b(multiply_16tx16t(qq, ww) >> 15, multiply_16tx16t(ii, ww) >> 15);
+  }
+}
+
+#endif
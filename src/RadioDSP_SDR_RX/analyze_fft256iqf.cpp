@@ -0,0 +1,135 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <Arduino.h>
+#include "analyze_fft256iqf.h"
+
+// log2 of a positive float in q8.8, from the exponent and the
+// first 6 bits of the mantissa (same table of the q15 analyzer)
+static inline int32_t log2f_q88(float32_t x)
+{
+  union { float32_t f; uint32_t u; } v;
+  v.f = x;
+  int32_t e = (int32_t)((v.u >> 23) & 0xFF) - 127;
+  return e * 256 + fftiq_log2_frac[(v.u >> 17) & 63];
+}
+
+void AudioAnalyzeFFT256IQF::update(void)
+{
+  audio_block_t *block_i,*block_q;
+  uint32_t start = ARM_DWT_CYCCNT;
+
+  block_i = receiveReadOnly(0);
+  block_q = receiveReadOnly(1);
+  if (!block_i || !block_q) {
+    if (block_i) release(block_i);
+    if (block_q) release(block_q);
+    return;
+  }
+
+  int16_t blk[2][AUDIO_BLOCK_SAMPLES];
+  conditioner.process(block_i->data, block_q->data, blk[0], blk[1], AUDIO_BLOCK_SAMPLES);
+  release(block_i);
+  release(block_q);
+
+  // hand the last two blocks to loop(), unless it did not take the previous ones
+  if (haveLast && !pending) {
+    memcpy(&raw[0][0], last[0], sizeof(last[0]));
+    memcpy(&raw[1][0], last[1], sizeof(last[1]));
+    memcpy(&raw[0][AUDIO_BLOCK_SAMPLES], blk[0], sizeof(last[0]));
+    memcpy(&raw[1][AUDIO_BLOCK_SAMPLES], blk[1], sizeof(last[1]));
+    pending = fftiqWorkQueue().post(deferred, this);
+  }
+  memcpy(last[0], blk[0], sizeof(last[0]));
+  memcpy(last[1], blk[1], sizeof(last[1]));
+  haveLast = true;
+  isrcycles = ARM_DWT_CYCCNT - start;
+}
+
+void AudioAnalyzeFFT256IQF::deferred(void *arg)
+{
+  AudioAnalyzeFFT256IQF *self = (AudioAnalyzeFFT256IQF *)arg;
+  uint32_t start = ARM_DWT_CYCCNT;
+  self->process();
+  __DMB();               // raw[] is read before the ISR may refill it
+  self->pending = false;
+  self->cycles = ARM_DWT_CYCCNT - start;
+}
+
+void AudioAnalyzeFFT256IQF::process(void)
+{
+  const float32_t scale = 1.0 / 32768.0;
+
+  for (int i = 0; i < 256; i++) {
+    float32_t w = window ? window[i] * scale : 1.0;
+    buffer[2 * i]     = raw[0][i] * w;
+    buffer[2 * i + 1] = raw[1][i] * w;
+  }
+  arm_cfft_f32(&arm_cfft_sR_f32_len256, buffer, 0, 1);
+
+  // |X|^2 in the units of the q15 analyzer (its FFT divides by 256)
+  arm_cmplx_mag_squared_f32(buffer, buffer, 256);
+  arm_scale_f32(buffer, 1.0 / 65536.0, buffer, 256);
+
+  if (avgmode == FFTIQ_AVG_BLOCK) {
+    float32_t k = 1.0 / naverage;
+    for (int i = 0; i < 256; i++) {
+      sum[i] = (count == 0) ? buffer[i] * k : sum[i] + buffer[i] * k;
+    }
+    if (++count < naverage) return;
+    count = 0;
+  } else {
+    float32_t k = ldexpf(1.0f, -avgparam);
+    for (int i = 0; i < 256; i++) {
+      float32_t acc = sum[i], m = buffer[i];
+      if (count == 0) acc = m;
+      else if (avgmode == FFTIQ_AVG_PEAK) { acc -= acc * k; if (m > acc) acc = m; }
+      else if (avgmode == FFTIQ_AVG_MIN)  { acc += acc * k; if (m < acc) acc = m; }
+      else acc += (m - acc) * k;
+      sum[i] = acc;
+    }
+    count = 1;
+  }
+
+  uint16_t *output = frames.beginWrite();
+  if (!output) return;
+
+  for (int i = 0; i < 256; i++) {
+    uint16_t v;
+    if (outputdb) {
+      // 10 * log10(2) = 3.0103 -> 771 / 256
+      int32_t db = (sum[i] > 0.0) ? ((log2f_q88(sum[i]) * 771) >> 8) + dboffset : 0;
+      v = (db < 0) ? 0 : (db > 0xFFFF) ? 0xFFFF : db;
+    } else {
+      float32_t mag;
+      arm_sqrt_f32(sum[i], &mag);
+      v = (mag > 65535.0) ? 65535 : (uint16_t)mag;
+    }
+    output[255 - (i ^ 128)] = v;
+  }
+  frames.commit();
+}
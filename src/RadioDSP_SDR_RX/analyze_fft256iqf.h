@@ -0,0 +1,147 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef analyze_fft256iqf_h_
+#define analyze_fft256iqf_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "arm_math.h"
+#include "arm_const_structs.h"
+#include "analyze_fftiq_common.h"
+#include "analyze_fft256iq.h"
+
+// Float version of AudioAnalyzeFFT256IQ, with the same API.
+//
+// The q15 radix-4 FFT scales by 1/4 at each of its 4 stages: 8 of the
+// 16 input bits are lost, so a weak carrier ends under the quantization
+// floor about 48 dB below a full scale one. arm_cfft_f32 has no such
+// scaling: the floor is the 16 bit input itself, plus the processing
+// gain of 256 points. The price is the float conversion and a float
+// FFT; to keep it out of the audio interrupt the ISR only copies the
+// samples, and the FFT runs in loop() through fftiqWorkQueue():
+//
+//   loop() { fftiqWorkQueue().runDeferred(); ... }
+//
+// cyclesPerFFT() returns the loop() cost of one spectrum, isrCycles()
+// the cost left in the interrupt. Frames are dropped (not queued) when
+// loop() is late, the spectrum is only for display.
+//
+// Output scale: the linear output is the same as the q15 analyzer. The
+// dB output is 10*log10(|X|^2) + offset in the q15 analyzer units, so
+// the extra range is below 0 dB: use a positive offset to show it.
+
+class AudioAnalyzeFFT256IQF : public AudioStream
+{
+public:
+  AudioAnalyzeFFT256IQF() : AudioStream(2, inputQueueArray),
+    window(AudioWindowBlackmanNuttall256), haveLast(false), pending(false),
+    count(0), naverage(8), avgmode(FFTIQ_AVG_BLOCK), avgparam(0),
+    outputdb(false), dboffset(0), cycles(0), isrcycles(0) {
+  }
+
+  bool available() {
+    return frames.available();
+  }
+
+  const uint16_t *lockFrame() {
+    return frames.lock();
+  }
+
+  void unlockFrame() {
+    frames.unlock();
+  }
+
+  uint32_t frameSequence() {
+    return frames.sequence();
+  }
+
+  float read(unsigned int binNumber) {
+    if (binNumber > 255) return 0.0;
+    return (float)(frames.latest()[binNumber]) * (1.0 / 16384.0);
+  }
+
+  void averageTogether(uint8_t n) {
+    if (n == 0) n = 1;
+    naverage = n;
+    avgmode = FFTIQ_AVG_BLOCK;
+  }
+
+  // FFTIQ_AVG_xxx engines, LINEAR runs as EXP
+  void averageMode(uint8_t mode, uint8_t param) {
+    if (mode == FFTIQ_AVG_LINEAR) mode = FFTIQ_AVG_EXP;
+    param = fftiq_average_param(mode, param);
+    avgmode = mode;
+    avgparam = param;
+    count = 0;
+  }
+
+  void windowFunction(const int16_t *w) {
+    window = w;
+  }
+
+  void outputDb(bool enable, int16_t offset_q88 = 0) {
+    outputdb = enable;
+    dboffset = offset_q88;
+  }
+
+  void dcRemoval(bool enable, uint8_t shift = FFTIQ_DC_SHIFT_DEFAULT) {
+    conditioner.dcRemoval(enable, shift);
+  }
+
+  void iqCorrection(bool enable, float gain = 1.0, float phase = 0.0) {
+    conditioner.iqCorrection(enable, gain, phase);
+  }
+
+  uint32_t cyclesPerFFT() { return cycles; }
+  uint32_t isrCycles() { return isrcycles; }
+
+  virtual void update(void);
+
+private:
+  static void deferred(void *arg);
+  void process(void);
+
+  const int16_t *window;
+  int16_t  last[2][AUDIO_BLOCK_SAMPLES];
+  int16_t  raw[2][256];              // snapshot handed to loop()
+  float32_t buffer[512] __attribute__ ((aligned (4)));
+  float32_t sum[256];
+  bool     haveLast;
+  volatile bool pending;
+  uint8_t  count;
+  uint8_t  naverage;
+  uint8_t  avgmode, avgparam;
+  bool     outputdb;
+  int16_t  dboffset;
+  uint32_t cycles, isrcycles;
+  FFTIQFrames<256> frames;
+  FFTIQConditioner conditioner;
+  audio_block_t *inputQueueArray[2];
+};
+
+#endif
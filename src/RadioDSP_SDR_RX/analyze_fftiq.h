@@ -0,0 +1,440 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef analyze_fftiq_h_
+#define analyze_fftiq_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "arm_math.h"
+#include "arm_const_structs.h"
+#include "utility/sqrt_integer.h"
+#include "utility/dspinst.h"
+#include "analyze_fftiq_common.h"
+
+// Complex (I & Q) analyzer with selectable FFT size, derived from
+// AudioAnalyzeFFT256IQ. The incoming samples are copied (interleaved I/Q)
+// into a ring of the last N samples, so no audio memory is retained, and
+// the FFT runs every N*(1-overlap) samples.
+//
+//   AudioAnalyzeFFTIQ<1024> FFT;   // 43 Hz per bin at 44.1 kHz
+//   FFT.setOverlap(FFTIQ_OVERLAP_50);
+//
+// Zoom mode: the stream is mixed down so that offsetHz goes to DC and
+// decimated by 2/4/8/16 (3 stages CIC + 2:1 FIR) before the FFT, the
+// resolution becomes fs / (decimation * N) around the tuned signal.
+//
+//   FFT.setZoom(16, TuningOffset);  // 512 points -> 5.4 Hz per bin
+//
+// setOffset() moves only the mixer, the filters and the averages keep
+// going; enable(false) releases the blocks unprocessed, for an analyzer
+// whose view is not shown.
+//
+// cyclesPerFFT() and cpuLoad() report the cost, to choose the size
+// the CPU budget allows.
+
+#define FFTIQ_OVERLAP_0    0
+#define FFTIQ_OVERLAP_50   1
+#define FFTIQ_OVERLAP_75   2
+
+#define FFTIQ_WINDOW_HANNING          0
+#define FFTIQ_WINDOW_BLACKMAN_NUTTALL 1
+
+#define FFTIQ_ZOOM_FIR_TAPS  16
+#define FFTIQ_CIC_STAGES     3
+
+template <uint16_t N>
+class AudioAnalyzeFFTIQ : public AudioStream
+{
+  static_assert(N == 512 || N == 1024 || N == 2048, "FFT size must be 512, 1024 or 2048");
+
+public:
+  AudioAnalyzeFFTIQ() : AudioStream(2, inputQueueArray),
+    wr(0), filled(0), hop(N / 2), sinceLast(0), count(0),
+    naverage(8), cycles(0), cyclesMax(0), fftCount(0),
+    decimation(1), cicRate(1), cicShift(0), cicCount(0),
+    phase(0), phaseInc(0), firIdx(0), firPhase(0), enabled(true), outputdb(false), dboffset(0),
+    avgmode(FFTIQ_AVG_BLOCK), avgparam(0) {
+    switch (N) {
+      case 512:  fft_inst = &arm_cfft_sR_q15_len512;  break;
+      case 1024: fft_inst = &arm_cfft_sR_q15_len1024; break;
+      default:   fft_inst = &arm_cfft_sR_q15_len2048; break;
+    }
+    windowFunction(FFTIQ_WINDOW_BLACKMAN_NUTTALL);
+    initZoomFilter();
+  }
+
+  // same frame protocol of AudioAnalyzeFFT256IQ
+  bool available() {
+    return frames.available();
+  }
+
+  const uint16_t *lockFrame() {
+    return frames.lock();
+  }
+
+  void unlockFrame() {
+    frames.unlock();
+  }
+
+  uint32_t frameSequence() {
+    return frames.sequence();
+  }
+
+  float read(unsigned int binNumber) {
+    if (binNumber > N - 1) return 0.0;
+    return (float)(frames.latest()[binNumber]) * (1.0 / 16384.0);
+  }
+
+  void averageTogether(uint8_t n) {
+    if (n == 0) n = 1;
+    naverage = n;
+    avgmode = FFTIQ_AVG_BLOCK;
+  }
+
+  // FFTIQ_AVG_xxx engines of analyze_fftiq_common.h. The history of
+  // the LINEAR engine would be too large at these sizes, it runs as EXP.
+  void averageMode(uint8_t mode, uint8_t param) {
+    if (mode == FFTIQ_AVG_LINEAR) mode = FFTIQ_AVG_EXP;
+    param = fftiq_average_param(mode, param);
+    __disable_irq();
+    avgmode = mode;
+    avgparam = param;
+    count = 0;
+    __enable_irq();
+  }
+
+  void setOverlap(uint8_t overlap) {
+    switch (overlap) {
+      case FFTIQ_OVERLAP_0:  hop = N;     break;
+      case FFTIQ_OVERLAP_75: hop = N / 4; break;
+      default:               hop = N / 2; break;
+    }
+  }
+
+  // The 256 points tables of windows.c do not fit, the window is computed here
+  void windowFunction(uint8_t type) {
+    for (int i = 0; i < N; i++) {
+      float x = 2.0 * PI * i / (N - 1);
+      float w;
+      if (type == FFTIQ_WINDOW_HANNING)
+        w = 0.5 - 0.5 * cosf(x);
+      else
+        w = 0.3635819 - 0.4891775 * cosf(x) + 0.1365995 * cosf(2 * x) - 0.0106411 * cosf(3 * x);
+      window[i] = (int16_t)(w * 32767.0);
+    }
+  }
+
+  // When enabled output[] holds 10*log10(|X|^2) + offset in dB q8.8
+  void outputDb(bool enable, int16_t offset_q88 = 0) {
+    outputdb = enable;
+    dboffset = offset_q88;
+  }
+
+  // decimation 1 = zoom off; 2, 4, 8, 16 zoom around offsetHz
+  bool setZoom(uint8_t decim, float offsetHz) {
+    if (decim != 1 && decim != 2 && decim != 4 && decim != 8 && decim != 16) return false;
+    __disable_irq();
+    decimation = decim;
+    cicRate = (decim > 1) ? decim / 2 : 1;
+    cicShift = 0;
+    for (uint8_t r = cicRate; r > 1; r >>= 1) cicShift += FFTIQ_CIC_STAGES;
+    setOffset(offsetHz);
+    memset(cicInt, 0, sizeof(cicInt));
+    memset(cicComb, 0, sizeof(cicComb));
+    memset(firLine, 0, sizeof(firLine));
+    cicCount = 0;
+    firIdx = 0;
+    firPhase = 0;
+    filled = 0;
+    sinceLast = 0;
+    count = 0;
+    __enable_irq();
+    return true;
+  }
+
+  // retune the mixer only, one word written: no reset of the history
+  void setOffset(float offsetHz) {
+    phaseInc = (uint32_t)(int32_t)(-offsetHz / AUDIO_SAMPLE_RATE_EXACT * 4294967296.0);
+  }
+
+  // disabled, update() only releases the blocks; the FFT restarts from
+  // an empty ring when enabled again
+  void enable(bool enable) {
+    __disable_irq();
+    enabled = enable;
+    filled = 0;
+    sinceLast = 0;
+    count = 0;
+    __enable_irq();
+  }
+
+  bool isEnabled() { return enabled; }
+
+  void dcRemoval(bool enable, uint8_t shift = FFTIQ_DC_SHIFT_DEFAULT) {
+    conditioner.dcRemoval(enable, shift);
+  }
+
+  void iqCorrection(bool enable, float gain = 1.0, float phase = 0.0) {
+    conditioner.iqCorrection(enable, gain, phase);
+  }
+
+  uint8_t  zoom() { return decimation; }
+  uint32_t cyclesPerFFT() { return cycles; }
+  uint32_t cyclesPerFFTMax() { return cyclesMax; }
+  uint32_t fftsDone() { return fftCount; }
+  float    binWidth() { return AUDIO_SAMPLE_RATE_EXACT / (decimation * N); }
+
+  // percentage of the CPU used by the FFT part at the current overlap and zoom
+  float cpuLoad() {
+    float fftRate = AUDIO_SAMPLE_RATE_EXACT / (decimation * hop);
+    return (float)cycles * fftRate * 100.0 / F_CPU_ACTUAL;
+  }
+
+  virtual void update(void);
+
+private:
+  void initZoomFilter(void);
+  void zoomSample(int16_t re, int16_t im);
+  void pushSample(uint32_t iq);
+  void process(void);
+
+  const arm_cfft_instance_q15 *fft_inst;
+  int16_t  window[N];
+  uint32_t ring[N];                // packed I | Q << 16
+  int16_t  buffer[2 * N] __attribute__ ((aligned (4)));
+  uint32_t sum[N];
+  uint16_t wr;                     // next sample slot to write
+  uint16_t filled;
+  uint16_t hop;
+  uint16_t sinceLast;
+  uint8_t  count;
+  uint8_t  naverage;
+  FFTIQFrames<N> frames;
+  FFTIQConditioner conditioner;
+  uint32_t cycles, cyclesMax, fftCount;
+
+  // zoom chain: NCO mixer -> CIC decimator -> 2:1 FIR
+  uint8_t  decimation, cicRate, cicShift, cicCount;
+  uint32_t phase, phaseInc;
+  int16_t  sinTab[256];
+  int32_t  cicInt[2][FFTIQ_CIC_STAGES];
+  int32_t  cicComb[2][FFTIQ_CIC_STAGES];
+  int16_t  firCoef[FFTIQ_ZOOM_FIR_TAPS];
+  int16_t  firLine[2][2 * FFTIQ_ZOOM_FIR_TAPS];   // doubled to read it without wrap
+  uint8_t  firIdx, firPhase;
+  bool     enabled;
+  bool     outputdb;
+  int16_t  dboffset;
+  uint8_t  avgmode, avgparam;
+
+  audio_block_t *inputQueueArray[2];
+};
+
+template <uint16_t N>
+void AudioAnalyzeFFTIQ<N>::initZoomFilter(void)
+{
+  for (int i = 0; i < 256; i++) {
+    sinTab[i] = (int16_t)(32767.0 * sinf(2.0 * PI * i / 256.0));
+  }
+  // Hamming windowed sinc, cutoff at fs/4 of the FIR input rate
+  float c[FFTIQ_ZOOM_FIR_TAPS], total = 0.0;
+  for (int i = 0; i < FFTIQ_ZOOM_FIR_TAPS; i++) {
+    float x = i - 0.5 * (FFTIQ_ZOOM_FIR_TAPS - 1);
+    float w = 0.54 - 0.46 * cosf(2.0 * PI * i / (FFTIQ_ZOOM_FIR_TAPS - 1));
+    c[i] = (x == 0.0) ? 0.5 : sinf(0.5 * PI * x) / (PI * x);
+    c[i] *= w;
+    total += c[i];
+  }
+  for (int i = 0; i < FFTIQ_ZOOM_FIR_TAPS; i++) {
+    firCoef[i] = (int16_t)(32767.0 * c[i] / total);
+  }
+}
+
+template <uint16_t N>
+inline void AudioAnalyzeFFTIQ<N>::pushSample(uint32_t iq)
+{
+  ring[wr] = iq;
+  wr = (wr + 1) & (N - 1);
+  if (filled < N) filled++;
+  if (++sinceLast < hop || filled < N) return;
+  sinceLast = 0;
+
+  uint32_t start = ARM_DWT_CYCCNT;
+  process();
+  cycles = ARM_DWT_CYCCNT - start;
+  if (cycles > cyclesMax) cyclesMax = cycles;
+  fftCount++;
+}
+
+template <uint16_t N>
+inline void AudioAnalyzeFFTIQ<N>::zoomSample(int16_t re, int16_t im)
+{
+  // mix: multiply by exp(-j * 2pi * offset * n / fs)
+  uint8_t idx = phase >> 24;
+  int32_t s = sinTab[idx];
+  int32_t c = sinTab[(uint8_t)(idx + 64)];
+  phase += phaseInc;
+  int32_t x[2];
+  x[0] = (re * c - im * s) >> 15;
+  x[1] = (re * s + im * c) >> 15;
+
+  // CIC decimator, the integrators wrap around by design
+  if (cicRate > 1) {
+    for (int ch = 0; ch < 2; ch++) {
+      int32_t v = x[ch];
+      for (int k = 0; k < FFTIQ_CIC_STAGES; k++) v = (cicInt[ch][k] += v);
+    }
+    if (++cicCount < cicRate) return;
+    cicCount = 0;
+    for (int ch = 0; ch < 2; ch++) {
+      int32_t v = cicInt[ch][FFTIQ_CIC_STAGES - 1];
+      for (int k = 0; k < FFTIQ_CIC_STAGES; k++) {
+        int32_t d = v - cicComb[ch][k];
+        cicComb[ch][k] = v;
+        v = d;
+      }
+      x[ch] = v >> cicShift;
+    }
+  }
+
+  // 2:1 FIR, evaluated only for the kept samples
+  for (int ch = 0; ch < 2; ch++) {
+    firLine[ch][firIdx] = firLine[ch][firIdx + FFTIQ_ZOOM_FIR_TAPS] = (int16_t)__SSAT(x[ch], 16);
+  }
+  if (++firIdx == FFTIQ_ZOOM_FIR_TAPS) firIdx = 0;
+  firPhase ^= 1;
+  if (firPhase) return;
+
+  int32_t acc[2] = {0, 0};
+  for (int ch = 0; ch < 2; ch++) {
+    const int16_t *line = &firLine[ch][firIdx];
+    for (int k = 0; k < FFTIQ_ZOOM_FIR_TAPS; k++) acc[ch] += (line[k] * firCoef[k]) >> 2;
+    acc[ch] = __SSAT(acc[ch] >> 13, 16);
+  }
+  pushSample((uint16_t)acc[0] | ((uint32_t)(uint16_t)acc[1] << 16));
+}
+
+template <uint16_t N>
+void AudioAnalyzeFFTIQ<N>::update(void)
+{
+  audio_block_t *block_i, *block_q;
+
+  block_i = receiveReadOnly(0);
+  block_q = receiveReadOnly(1);
+  if (!block_i || !block_q) {
+    if (block_i) release(block_i);
+    if (block_q) release(block_q);
+    return;
+  }
+  if (!enabled) {
+    release(block_i);
+    release(block_q);
+    return;
+  }
+
+  int16_t blk[2][AUDIO_BLOCK_SAMPLES];
+  const int16_t *src1 = block_i->data;
+  const int16_t *src2 = block_q->data;
+  if (conditioner.active()) {
+    conditioner.process(src1, src2, blk[0], blk[1], AUDIO_BLOCK_SAMPLES);
+    src1 = blk[0];
+    src2 = blk[1];
+  }
+  if (decimation == 1) {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+      pushSample((uint16_t)*src1++ | ((uint32_t)(uint16_t)*src2++ << 16));
+    }
+  } else {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+      zoomSample(*src1++, *src2++);
+    }
+  }
+  release(block_i);
+  release(block_q);
+}
+
+template <uint16_t N>
+void AudioAnalyzeFFTIQ<N>::process(void)
+{
+  // oldest sample is at wr: unroll the ring and apply the window
+  uint32_t *dst = (uint32_t *)buffer;
+  uint16_t idx = wr;
+  for (int i = 0; i < N; i++) {
+    uint32_t iq = ring[idx];
+    int16_t re = (int16_t)(iq & 0xFFFF);
+    int16_t im = (int16_t)(iq >> 16);
+    re = (re * window[i]) >> 15;
+    im = (im * window[i]) >> 15;
+    *dst++ = (uint16_t)re | ((uint32_t)(uint16_t)im << 16);
+    idx = (idx + 1) & (N - 1);
+  }
+
+  arm_cfft_q15(fft_inst, buffer, 0, 1);
+
+  uint32_t *bins = (uint32_t *)buffer;
+  if (avgmode == FFTIQ_AVG_BLOCK) {
+    if (count == 0) {
+      for (int i = 0; i < N; i++) {
+        uint32_t tmp = bins[i];
+        uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+        sum[i] = magsq / naverage;
+      }
+    } else {
+      for (int i = 0; i < N; i++) {
+        uint32_t tmp = bins[i];
+        uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+        sum[i] += magsq / naverage;
+      }
+    }
+    if (++count < naverage) return;
+    count = 0;
+  } else {
+    for (int i = 0; i < N; i++) {
+      uint32_t tmp = bins[i];
+      uint32_t magsq = multiply_16tx16t_add_16bx16b(tmp, tmp);
+      sum[i] = (count == 0) ? magsq : fftiq_average_step(avgmode, avgparam, sum[i], magsq);
+    }
+    count = 1;
+  }
+
+  uint16_t *output = frames.beginWrite();
+  if (!output) return;   // loop() still reads the other frame
+
+  if (outputdb) {
+    for (int i = 0; i < N; i++) {
+      output[N - 1 - (i ^ (N / 2))] = fftiq_magsq_to_db_q88(sum[i], dboffset);
+    }
+  } else {
+    for (int i = 0; i < N; i++) {
+      output[N - 1 - (i ^ (N / 2))] = sqrt_uint32_approx(sum[i]);
+    }
+  }
+  frames.commit();
+}
+
+#endif
@@ -0,0 +1,266 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef analyze_fftiq_common_h_
+#define analyze_fftiq_common_h_
+
+#include "Arduino.h"
+
+// Helpers shared by AudioAnalyzeFFT256IQ and AudioAnalyzeFFTIQ<N>
+
+// log2(1 + i/64) in 1/256 units
+static const uint8_t fftiq_log2_frac[64] = {
+  0, 6, 11, 17, 22, 28, 33, 38, 44, 49, 54, 59, 63, 68, 73, 78,
+  82, 87, 92, 96, 100, 105, 109, 113, 118, 122, 126, 130, 134, 138, 142, 146,
+  150, 154, 157, 161, 165, 169, 172, 176, 179, 183, 186, 190, 193, 197, 200, 203,
+  207, 210, 213, 216, 220, 223, 226, 229, 232, 235, 238, 241, 244, 247, 250, 253
+};
+
+// log2(x) in q8.8, x > 0: integer part from the leading zeros, fraction
+// from the 6 bits that follow the leading one
+static inline uint16_t fftiq_log2_q88(uint32_t x)
+{
+  uint32_t msb = 31 - __builtin_clz(x);
+  uint32_t frac = (msb >= 6) ? (x >> (msb - 6)) & 63 : (x << (6 - msb)) & 63;
+  return (msb << 8) | fftiq_log2_frac[frac];
+}
+
+// 10 * log10(magsq) + offset in q8.8 dB, clamped at 0.
+// 10 * log10(2) = 3.0103 -> 771 / 256
+static inline uint16_t fftiq_magsq_to_db_q88(uint32_t magsq, int16_t offset_q88)
+{
+  if (magsq == 0) return 0;
+  int32_t db = ((int32_t)fftiq_log2_q88(magsq) * 771) >> 8;
+  db += offset_q88;
+  if (db < 0) db = 0;
+  return (uint16_t)db;
+}
+
+// Averaging engines. BLOCK is the original averageTogether(n): n spectra
+// are summed and one frame is published every n updates. The others
+// publish a fresh frame at every update:
+//   EXP     one pole IIR, time constant 2^param updates (no division)
+//   LINEAR  moving average of the last 2^param spectra (param <= 3)
+//   PEAK    peak hold, decays by 1/2^param of the value per update
+//   MIN     min hold for the noise floor, rises by 1/2^param per update
+#define FFTIQ_AVG_BLOCK   0
+#define FFTIQ_AVG_EXP     1
+#define FFTIQ_AVG_LINEAR  2
+#define FFTIQ_AVG_PEAK    3
+#define FFTIQ_AVG_MIN     4
+
+#define FFTIQ_LINEAR_MAX_SHIFT 3
+
+// Valid param for a mode: MIN needs at least 1 (with 0 the rise would
+// double the value at every update), no shift beyond the 32 bits
+static inline uint8_t fftiq_average_param(uint8_t mode, uint8_t param)
+{
+  if (mode == FFTIQ_AVG_LINEAR && param > FFTIQ_LINEAR_MAX_SHIFT) return FFTIQ_LINEAR_MAX_SHIFT;
+  if (mode == FFTIQ_AVG_MIN && param < 1) return 1;
+  if (param > 31) return 31;
+  return param;
+}
+
+// One step of the EXP / PEAK / MIN engines on the magnitude squared
+static inline uint32_t fftiq_average_step(uint8_t mode, uint8_t param, uint32_t acc, uint32_t magsq)
+{
+  switch (mode) {
+    case FFTIQ_AVG_PEAK:
+      acc -= acc >> param;
+      return (magsq > acc) ? magsq : acc;
+    case FFTIQ_AVG_MIN: {
+      uint32_t rise = (acc >> param) + 1;
+      acc = (acc > 0xFFFFFFFF - rise) ? 0xFFFFFFFF : acc + rise;   // saturate
+      return (magsq < acc) ? magsq : acc;
+    }
+    default:
+      return acc - (acc >> param) + (magsq >> param);
+  }
+}
+
+// Double buffered output frames. The audio ISR writes the back buffer
+// and publishes it by swapping the index and bumping the sequence
+// counter; loop() gets a stable pointer with lock() until unlock().
+// While the reader holds a frame the writer skips its publish (the
+// averages keep running), so a held frame is never rewritten.
+template <uint16_t N>
+class FFTIQFrames
+{
+public:
+  FFTIQFrames() : front(0), held(NONE), seq(0), readSeq(0) {
+    memset(buf, 0, sizeof(buf));
+  }
+
+  // ISR side: buffer to fill, NULL if the reader still holds it
+  uint16_t *beginWrite() {
+    uint8_t back = front ^ 1;
+    return (held == back) ? NULL : buf[back];
+  }
+  void commit() {
+    front ^= 1;
+    seq++;
+  }
+
+  // loop() side
+  bool available() {
+    return seq != readSeq;
+  }
+  const uint16_t *lock() {
+    __disable_irq();
+    uint8_t f = front;
+    held = f;
+    readSeq = seq;
+    __enable_irq();
+    return buf[f];
+  }
+  void unlock() {
+    held = NONE;
+  }
+  uint32_t sequence() {
+    return seq;
+  }
+  const uint16_t *latest() {
+    return buf[front];
+  }
+
+private:
+  static const uint8_t NONE = 0xFF;
+  uint16_t buf[2][N] __attribute__ ((aligned (4)));
+  volatile uint8_t  front;
+  volatile uint8_t  held;
+  volatile uint32_t seq;
+  uint32_t readSeq;
+};
+
+// Input conditioning done while the block is copied: one pole DC tracker
+// per channel (removes the LO leakage spike at the centre of the
+// panadapter) and optional IQ imbalance correction:
+//   Q' = gain * Q + phase * I
+// I is the reference; a balance given for I (gain * I) is 1 / gain here.
+#define FFTIQ_DC_SHIFT_DEFAULT 7     // ~55 Hz corner at 44.1 kHz
+
+class FFTIQConditioner
+{
+public:
+  FFTIQConditioner() : dcI(0), dcQ(0), dcShift(FFTIQ_DC_SHIFT_DEFAULT),
+    dcEnabled(false), iqEnabled(false), gain_q14(16384), phase_q15(0) {}
+
+  void dcRemoval(bool enable, uint8_t shift = FFTIQ_DC_SHIFT_DEFAULT) {
+    dcShift = shift;
+    dcEnabled = enable;
+  }
+
+  void iqCorrection(bool enable, float gain = 1.0, float phase = 0.0) {
+    gain_q14 = (int16_t)(gain * 16384.0);
+    phase_q15 = (int16_t)(phase * 32767.0);
+    iqEnabled = enable;
+  }
+
+  bool active() { return dcEnabled || iqEnabled; }
+
+  void process(const int16_t *inI, const int16_t *inQ, int16_t *outI, int16_t *outQ, int n) {
+    for (int k = 0; k < n; k++) {
+      int32_t i = inI[k];
+      int32_t q = inQ[k];
+      if (iqEnabled) {
+        q = __SSAT(((q * gain_q14) >> 14) + ((i * phase_q15) >> 15), 16);
+      }
+      if (dcEnabled) {
+        // dc in q8, follows the input with a time constant of 2^dcShift samples
+        dcI += ((i << 8) - dcI) >> dcShift;
+        dcQ += ((q << 8) - dcQ) >> dcShift;
+        i -= dcI >> 8;
+        q -= dcQ >> 8;
+      }
+      outI[k] = __SSAT(i, 16);
+      outQ[k] = __SSAT(q, 16);
+    }
+  }
+
+private:
+  int32_t dcI, dcQ;
+  uint8_t dcShift;
+  bool    dcEnabled, iqEnabled;
+  int16_t gain_q14, phase_q15;
+};
+
+// Deferred work: the ISR side of an analyzer posts a job, loop() runs it
+// with runDeferred(). Single producer (audio ISR), single consumer (loop).
+#define FFTIQ_WORK_SLOTS 4
+
+class FFTIQWorkQueue
+{
+public:
+  typedef void (*job_t)(void *arg);
+
+  FFTIQWorkQueue() : head(0), tail(0), dropped(0) {}
+
+  // ISR side, false when the queue is full (the job is dropped)
+  bool post(job_t job, void *arg) {
+    uint8_t next = (head + 1) % FFTIQ_WORK_SLOTS;
+    if (next == tail) {
+      dropped++;
+      return false;
+    }
+    jobs[head] = job;
+    args[head] = arg;
+    __DMB();               // the job is in memory before the new head
+    head = next;
+    return true;
+  }
+
+  // loop() side, runs what is pending, returns the number of jobs
+  int runDeferred() {
+    int n = 0;
+    while (tail != head) {
+      __DMB();
+      jobs[tail](args[tail]);
+      tail = (tail + 1) % FFTIQ_WORK_SLOTS;
+      n++;
+    }
+    return n;
+  }
+
+  // loop() side, true when there is something to run
+  bool pending() const { return tail != head; }
+
+  uint32_t droppedJobs() { return dropped; }
+
+private:
+  job_t    jobs[FFTIQ_WORK_SLOTS];
+  void    *args[FFTIQ_WORK_SLOTS];
+  volatile uint8_t head, tail;
+  uint32_t dropped;
+};
+
+inline FFTIQWorkQueue &fftiqWorkQueue()
+{
+  static FFTIQWorkQueue queue;
+  return queue;
+}
+
+#endif
@@ -0,0 +1,41 @@
+/**
+  ******************************************************************************
+  * @file    host_test.h
+  * @brief   Checks of the host tests
+  *
+  ******************************************************************************
+  *
+   */
+
+#ifndef HOST_TEST_H_INCLUDED
+#define HOST_TEST_H_INCLUDED
+
+#include <stdio.h>
+
+static int testChecks = 0;
+static int testFailures = 0;
+
+#define CHECK(cond) do {                                                  \
+    testChecks++;                                                         \
+    if (!(cond)) {                                                        \
+      testFailures++;                                                     \
+      printf("%s:%d: FAILED %s\n", __FILE__, __LINE__, #cond);            \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_STR(got, expected) do {                                     \
+    testChecks++;                                                         \
+    if (strcmp((got), (expected)) != 0) {                                 \
+      testFailures++;                                                     \
+      printf("%s:%d: FAILED got \"%s\" expected \"%s\"\n",                \
+             __FILE__, __LINE__, (got), (expected));                      \
+    }                                                                     \
+  } while (0)
+
+static int testResult(const char *name)
+{
+  printf("%s: %d checks, %d failed\n", name, testChecks, testFailures);
+  return testFailures ? 1 : 0;
+}
+
+#endif /* HOST_TEST_H_INCLUDED */
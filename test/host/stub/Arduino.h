@@ -0,0 +1,112 @@
+/**
+  ******************************************************************************
+  * @file    Arduino.h
+  * @brief   Host stand-in of the Teensy core, only what the tests need
+  *
+  ******************************************************************************
+  *
+  * Print/Stream as in the Teensy core (printf, availableForWrite), a
+  * clock the test moves by hand, pins and knob read from variables.
+  *
+   */
+
+#ifndef HOST_ARDUINO_H_INCLUDED
+#define HOST_ARDUINO_H_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+
+typedef bool     boolean;
+typedef uint8_t  byte;
+typedef unsigned long ulong;
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define LOW           0
+#define HIGH          1
+#define INPUT_PULLUP  2
+
+#define __DMB()       __sync_synchronize()
+
+// Teensy 4 core: no interrupts on the host, a cycle counter that only
+// counts reads (the cost numbers are meaningless here)
+#define __disable_irq()
+#define __enable_irq()
+static uint32_t hostCycles = 0;
+#define ARM_DWT_CYCCNT  (hostCycles++)
+#define F_CPU_ACTUAL    600000000
+#ifndef PI
+#define PI            3.1415926535897932384626433832795
+#endif
+
+//************************************************************************
+//      Print / Stream
+//************************************************************************
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  virtual int availableForWrite() { return 0; }
+
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  int printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+    if (n > (int)sizeof(buf) - 1) n = sizeof(buf) - 1;
+    return write((const uint8_t *)buf, n);
+  }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+//************************************************************************
+//      Time, pins, knob
+//************************************************************************
+static uint32_t hostMicros = 0;
+static uint8_t  hostPins[64];
+static int32_t  hostKnob = 0;
+
+static inline uint32_t micros() { return hostMicros; }
+static inline uint32_t millis() { return hostMicros / 1000; }
+
+static inline void    pinMode(uint8_t, uint8_t) {}
+static inline uint8_t digitalReadFast(uint8_t pin) { return hostPins[pin]; }
+
+class IntervalTimer
+{
+public:
+  bool begin(void (*)(), unsigned) { return true; }
+};
+
+class Encoder
+{
+public:
+  Encoder(uint8_t, uint8_t) {}
+  int32_t read() { return hostKnob; }
+};
+
+#endif /* HOST_ARDUINO_H_INCLUDED */
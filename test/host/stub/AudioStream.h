@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    AudioStream.h
+  * @brief   Host stand-in of the Teensy Audio AudioStream: the test hands
+  *          the blocks to the inputs and counts the releases
+  *
+  ******************************************************************************
+  *
+   */
+
+#ifndef HOST_AUDIOSTREAM_H_INCLUDED
+#define HOST_AUDIOSTREAM_H_INCLUDED
+
+#include <Arduino.h>
+
+#define AUDIO_BLOCK_SAMPLES      128
+#define AUDIO_SAMPLE_RATE_EXACT  44117.64706f
+
+typedef struct audio_block_struct {
+  int16_t data[AUDIO_BLOCK_SAMPLES];
+} audio_block_t;
+
+// the block each input gets at the next receive, NULL for none
+static audio_block_t *hostInput[2];
+static uint32_t       hostReleased = 0;
+
+class AudioStream
+{
+public:
+  AudioStream(unsigned char ninput, audio_block_t **iqueue) {}
+  virtual ~AudioStream() {}
+  virtual void update(void) = 0;
+
+protected:
+  audio_block_t *receiveReadOnly(unsigned int index = 0) {
+    audio_block_t *b = hostInput[index];
+    hostInput[index] = NULL;
+    return b;
+  }
+  static void release(audio_block_t *block) { hostReleased++; }
+};
+
+#endif /* HOST_AUDIOSTREAM_H_INCLUDED */
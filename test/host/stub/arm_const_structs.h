@@ -0,0 +1,10 @@
+/**
+  ******************************************************************************
+  * @file    arm_const_structs.h
+  * @brief   Host stand-in: the FFT instances are in the arm_math.h stub
+  *
+  ******************************************************************************
+  *
+   */
+
+#include "arm_math.h"
@@ -0,0 +1,359 @@
+/**
+  ******************************************************************************
+  * @file    arm_math.h
+  * @brief   Host stand-in of the CMSIS-DSP parts used by the analyzers
+  *
+  ******************************************************************************
+  *
+  * arm_cfft_q15 is a double precision FFT with the output scaling of the
+  * CMSIS one (1/N), rounded and saturated to q15.
+  *
+  * arm_cfft_radix4_q15 is the fixed point FFT: q15 twiddles, and each
+  * radix-2 stage halves its outputs and truncates them (the CMSIS radix-4
+  * divides by 4 every two such stages), so the 1/N scaling costs the
+  * same bits. arm_cfft_f32 is the double precision FFT, unscaled.
+  *
+  * arm_lms_norm_f32 / arm_lms_norm_q15 follow the reference C code of
+  * CMSIS-DSP step by step, with the same fixed point formats: the energy
+  * is summed in 32 bits and kept by the instance as q15_t, the q15 update
+  * uses 1 / energy with a post shift as arm_recip_q15 gives it (computed
+  * exactly here, CMSIS refines a table value with Newton-Raphson).
+  *
+   */
+
+#ifndef HOST_ARM_MATH_H_INCLUDED
+#define HOST_ARM_MATH_H_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+#include <complex>
+#include <vector>
+#include <string.h>
+
+typedef int16_t q15_t;
+
+static inline int32_t __SSAT(int32_t v, int bits)
+{
+  int32_t hi = (1 << (bits - 1)) - 1, lo = -(1 << (bits - 1));
+  return v > hi ? hi : (v < lo ? lo : v);
+}
+
+typedef struct {
+  uint16_t fftLen;
+} arm_cfft_instance_q15;
+
+static const arm_cfft_instance_q15 arm_cfft_sR_q15_len512  = {512};
+static const arm_cfft_instance_q15 arm_cfft_sR_q15_len1024 = {1024};
+static const arm_cfft_instance_q15 arm_cfft_sR_q15_len2048 = {2048};
+
+static void hostFft(std::vector<std::complex<double> > &x)
+{
+  size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    std::complex<double> w = std::polar(1.0, -2.0 * M_PI / len);
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> wk = 1.0;
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<double> u = x[i + k], v = x[i + k + len / 2] * wk;
+        x[i + k] = u + v;
+        x[i + k + len / 2] = u - v;
+        wk *= w;
+      }
+    }
+  }
+}
+
+static inline void arm_cfft_q15(const arm_cfft_instance_q15 *S, q15_t *p1,
+                                uint8_t ifftFlag, uint8_t bitReverseFlag)
+{
+  size_t n = S->fftLen;
+  std::vector<std::complex<double> > x(n);
+  for (size_t i = 0; i < n; i++) x[i] = std::complex<double>(p1[2 * i], p1[2 * i + 1]);
+  hostFft(x);
+  for (size_t i = 0; i < n; i++) {
+    p1[2 * i]     = __SSAT((int32_t)lround(x[i].real() / n), 16);
+    p1[2 * i + 1] = __SSAT((int32_t)lround(x[i].imag() / n), 16);
+  }
+}
+
+//************************************************************************
+//      Vector helpers
+//************************************************************************
+typedef float float32_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+static inline void arm_fill_f32(float32_t v, float32_t *dst, uint32_t n) { while (n--) *dst++ = v; }
+static inline void arm_fill_q15(q15_t v, q15_t *dst, uint32_t n) { while (n--) *dst++ = v; }
+static inline void arm_copy_f32(const float32_t *src, float32_t *dst, uint32_t n) { memmove(dst, src, n * sizeof(float32_t)); }
+static inline void arm_copy_q15(const q15_t *src, q15_t *dst, uint32_t n) { memmove(dst, src, n * sizeof(q15_t)); }
+
+static inline void arm_scale_f32(const float32_t *src, float32_t scale, float32_t *dst, uint32_t n)
+{
+  while (n--) *dst++ = *src++ * scale;
+}
+
+static inline void arm_power_f32(const float32_t *src, uint32_t n, float32_t *result)
+{
+  float32_t sum = 0.0f;
+  while (n--) { sum += *src * *src; src++; }
+  *result = sum;
+}
+
+static inline void arm_float_to_q15(const float32_t *src, q15_t *dst, uint32_t n)
+{
+  while (n--) *dst++ = (q15_t)__SSAT((q31_t)(*src++ * 32768.0f), 16);
+}
+
+static inline void arm_q15_to_float(const q15_t *src, float32_t *dst, uint32_t n)
+{
+  while (n--) *dst++ = *src++ / 32768.0f;
+}
+
+// left shift saturated, right shift arithmetic
+static inline void arm_shift_q15(const q15_t *src, int8_t shiftBits, q15_t *dst, uint32_t n)
+{
+  while (n--) {
+    q31_t v = *src++;
+    *dst++ = (shiftBits >= 0) ? (q15_t)__SSAT(v << shiftBits, 16) : (q15_t)(v >> -shiftBits);
+  }
+}
+
+static inline void arm_cmplx_mag_squared_f32(const float32_t *src, float32_t *dst, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++) dst[i] = src[2 * i] * src[2 * i] + src[2 * i + 1] * src[2 * i + 1];
+}
+
+typedef enum {
+  ARM_MATH_SUCCESS = 0,
+  ARM_MATH_ARGUMENT_ERROR = -1
+} arm_status;
+
+static inline arm_status arm_sqrt_f32(float32_t in, float32_t *out)
+{
+  *out = (in > 0.0f) ? sqrtf(in) : 0.0f;
+  return (in >= 0.0f) ? ARM_MATH_SUCCESS : ARM_MATH_ARGUMENT_ERROR;
+}
+
+//************************************************************************
+//      Radix-4 q15 and float FFT
+//************************************************************************
+typedef struct {
+  uint16_t fftLen;
+  uint8_t  ifftFlag;
+  uint8_t  bitReverseFlag;
+} arm_cfft_radix4_instance_q15;
+
+static inline arm_status arm_cfft_radix4_init_q15(arm_cfft_radix4_instance_q15 *S, uint16_t fftLen,
+                                                  uint8_t ifftFlag, uint8_t bitReverseFlag)
+{
+  S->fftLen = fftLen;
+  S->ifftFlag = ifftFlag;
+  S->bitReverseFlag = bitReverseFlag;
+  return ARM_MATH_SUCCESS;
+}
+
+// forward FFT, natural order out, scaled by 1/fftLen with truncation
+static inline void arm_cfft_radix4_q15(const arm_cfft_radix4_instance_q15 *S, q15_t *pSrc)
+{
+  size_t n = S->fftLen;
+  std::vector<int32_t> re(n), im(n);
+  for (size_t i = 0, j = 0; i < n; i++) {
+    re[j] = pSrc[2 * i];
+    im[j] = pSrc[2 * i + 1];
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    for (size_t k = 0; k < len / 2; k++) {
+      int32_t c = __SSAT((int32_t)lround(32768.0 * cos(2.0 * M_PI * k / len)), 16);
+      int32_t s = __SSAT((int32_t)lround(-32768.0 * sin(2.0 * M_PI * k / len)), 16);
+      for (size_t i = k; i < n; i += len) {
+        size_t m = i + len / 2;
+        int32_t vr = (re[m] * c - im[m] * s) >> 15;
+        int32_t vi = (re[m] * s + im[m] * c) >> 15;
+        int32_t ur = re[i], ui = im[i];
+        re[i] = (ur + vr) >> 1;
+        im[i] = (ui + vi) >> 1;
+        re[m] = (ur - vr) >> 1;
+        im[m] = (ui - vi) >> 1;
+      }
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    pSrc[2 * i]     = (q15_t)__SSAT(re[i], 16);
+    pSrc[2 * i + 1] = (q15_t)__SSAT(im[i], 16);
+  }
+}
+
+typedef struct {
+  uint16_t fftLen;
+} arm_cfft_instance_f32;
+
+static const arm_cfft_instance_f32 arm_cfft_sR_f32_len256 = {256};
+
+static inline void arm_cfft_f32(const arm_cfft_instance_f32 *S, float32_t *p1,
+                                uint8_t ifftFlag, uint8_t bitReverseFlag)
+{
+  size_t n = S->fftLen;
+  std::vector<std::complex<double> > x(n);
+  for (size_t i = 0; i < n; i++) x[i] = std::complex<double>(p1[2 * i], p1[2 * i + 1]);
+  hostFft(x);
+  for (size_t i = 0; i < n; i++) {
+    p1[2 * i]     = x[i].real();
+    p1[2 * i + 1] = x[i].imag();
+  }
+}
+
+//************************************************************************
+//      Normalized LMS
+//************************************************************************
+typedef struct {
+  uint16_t   numTaps;
+  float32_t *pState;
+  float32_t *pCoeffs;
+  float32_t  mu;
+  float32_t  energy;
+  float32_t  x0;
+} arm_lms_norm_instance_f32;
+
+typedef struct {
+  uint16_t   numTaps;
+  float32_t *pState;
+  float32_t *pCoeffs;
+  float32_t  mu;
+} arm_lms_instance_f32;
+
+typedef struct {
+  uint16_t   numTaps;
+  q15_t     *pState;
+  q15_t     *pCoeffs;
+  q15_t      mu;
+  uint8_t    postShift;
+  q15_t     *recipTable;
+  q15_t      energy;
+  q15_t      x0;
+} arm_lms_norm_instance_q15;
+
+static inline void arm_lms_norm_init_f32(arm_lms_norm_instance_f32 *S, uint16_t numTaps, float32_t *pCoeffs,
+                                         float32_t *pState, float32_t mu, uint32_t blockSize)
+{
+  S->numTaps = numTaps;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  S->mu = mu;
+  S->energy = 0.0f;
+  S->x0 = 0.0f;
+  memset(pState, 0, (numTaps + blockSize - 1) * sizeof(float32_t));
+}
+
+static inline void arm_lms_norm_f32(arm_lms_norm_instance_f32 *S, const float32_t *pSrc, float32_t *pRef,
+                                    float32_t *pOut, float32_t *pErr, uint32_t blockSize)
+{
+  float32_t *pState = S->pState;
+  float32_t *pCoeffs = S->pCoeffs;
+  float32_t *pStateCurnt = &S->pState[S->numTaps - 1];
+  uint32_t   numTaps = S->numTaps;
+  float32_t  energy = S->energy, x0 = S->x0, mu = S->mu;
+
+  for (uint32_t n = 0; n < blockSize; n++) {
+    *pStateCurnt++ = *pSrc;
+    float32_t in = *pSrc++;
+    energy -= x0 * x0;
+    energy += in * in;
+
+    float32_t acc = 0.0f;
+    for (uint32_t k = 0; k < numTaps; k++) acc += pState[k] * pCoeffs[k];
+    *pOut++ = acc;
+    float32_t e = *pRef++ - acc;
+    *pErr++ = e;
+
+    float32_t w = e * mu / (energy + 0.000000119209289f);
+    for (uint32_t k = 0; k < numTaps; k++) pCoeffs[k] += w * pState[k];
+
+    x0 = *pState++;
+  }
+  S->energy = energy;
+  S->x0 = x0;
+  memmove(S->pState, pState, (numTaps - 1) * sizeof(float32_t));
+}
+
+static inline void arm_lms_norm_init_q15(arm_lms_norm_instance_q15 *S, uint16_t numTaps, q15_t *pCoeffs,
+                                         q15_t *pState, q15_t mu, uint32_t blockSize, uint8_t postShift)
+{
+  S->numTaps = numTaps;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  S->mu = mu;
+  S->postShift = postShift;
+  S->recipTable = NULL;
+  S->energy = 0;
+  S->x0 = 0;
+  memset(pState, 0, (numTaps + blockSize - 1) * sizeof(q15_t));
+}
+
+// 1 / in, as arm_recip_q15: in * dst >> (15 - return) is 2^15
+static inline uint32_t host_recip_q15(q15_t in, q15_t *dst)
+{
+  if (in <= 0) {              // CMSIS has no answer either: no update
+    *dst = 0;
+    return 0;
+  }
+  uint32_t signBits = __builtin_clz((uint32_t)in) - 17;
+  int32_t  norm = (int32_t)in << signBits;          // 0x4000 .. 0x7FFF
+  *dst = (q15_t)__SSAT((int32_t)((1LL << 29) / norm), 16);
+  return signBits + 1;
+}
+
+// counts of the updates that met a wrapped (negative) q15 energy
+static uint32_t hostLmsEnergyWraps = 0;
+
+static inline void arm_lms_norm_q15(arm_lms_norm_instance_q15 *S, const q15_t *pSrc, q15_t *pRef,
+                                    q15_t *pOut, q15_t *pErr, uint32_t blockSize)
+{
+  q15_t   *pState = S->pState;
+  q15_t   *pCoeffs = S->pCoeffs;
+  q15_t   *pStateCurnt = &S->pState[S->numTaps - 1];
+  uint32_t numTaps = S->numTaps;
+  q31_t    energy = S->energy;
+  q15_t    x0 = S->x0, mu = S->mu;
+  uint32_t lShift = 15 - S->postShift;
+
+  for (uint32_t n = 0; n < blockSize; n++) {
+    *pStateCurnt++ = *pSrc;
+    q15_t in = *pSrc++;
+    energy -= (((q31_t)x0 * x0) >> 15);
+    energy += (((q31_t)in * in) >> 15);
+
+    q63_t acc = 0;
+    for (uint32_t k = 0; k < numTaps; k++) acc += (q31_t)pState[k] * pCoeffs[k];
+    acc = __SSAT((q31_t)(acc >> lShift), 16);
+    *pOut++ = (q15_t)acc;
+    q15_t e = (q15_t)__SSAT(*pRef++ - (q15_t)acc, 16);
+    *pErr++ = e;
+
+    q15_t oneByEnergy;
+    q15_t energy15 = (q15_t)((q15_t)energy + 5);    // DELTA_Q15
+    if (energy15 <= 0) hostLmsEnergyWraps++;
+    uint32_t postShift = host_recip_q15(energy15, &oneByEnergy);
+    q31_t errorXmu = ((q31_t)e * mu) >> 15;
+    acc = ((q63_t)errorXmu * oneByEnergy) >> (15 - postShift);
+    q15_t w = (q15_t)__SSAT((q31_t)acc, 16);
+    for (uint32_t k = 0; k < numTaps; k++)
+      pCoeffs[k] = (q15_t)__SSAT((q31_t)pCoeffs[k] + (((q31_t)w * pState[k]) >> 15), 16);
+
+    x0 = *pState++;
+  }
+  S->energy = (q15_t)energy;
+  S->x0 = x0;
+  memmove(S->pState, pState, (numTaps - 1) * sizeof(q15_t));
+}
+
+#endif /* HOST_ARM_MATH_H_INCLUDED */
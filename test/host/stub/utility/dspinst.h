@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    dspinst.h
+  * @brief   Host stub of the Teensy Audio dspinst.h, the intrinsics used by
+  *          the sketch in plain C with the same results
+  *
+  ******************************************************************************
+  *
+   */
+
+#ifndef HOST_DSPINST_H_INCLUDED
+#define HOST_DSPINST_H_INCLUDED
+
+#include <stdint.h>
+
+// ((a[15:0] << 16) | b[15:0])
+static inline uint32_t pack_16b_16b(int32_t a, int32_t b)
+{
+  return ((uint32_t)a << 16) | ((uint32_t)b & 0xFFFF);
+}
+
+// (a[31:16] | b[15:0])
+static inline uint32_t pack_16t_16b(int32_t a, int32_t b)
+{
+  return ((uint32_t)a & 0xFFFF0000) | ((uint32_t)b & 0xFFFF);
+}
+
+// each 16 bit lane: (a + b) / 2, signed, rounded down (SHADD16)
+static inline uint32_t signed_halving_add_16_and_16(uint32_t a, uint32_t b)
+{
+  int32_t top = ((int32_t)(int16_t)(a >> 16) + (int16_t)(b >> 16)) >> 1;
+  int32_t bot = ((int32_t)(int16_t)a + (int16_t)b) >> 1;
+  return ((uint32_t)top << 16) | ((uint32_t)bot & 0xFFFF);
+}
+
+// a[15:0] * b[15:0], signed (SMULBB)
+static inline int32_t multiply_16bx16b(uint32_t a, uint32_t b)
+{
+  return (int32_t)(int16_t)a * (int16_t)b;
+}
+
+// a[31:16] * b[31:16], signed (SMULTT)
+static inline int32_t multiply_16tx16t(uint32_t a, uint32_t b)
+{
+  return (int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16);
+}
+
+// a[31:16] * b[15:0], signed (SMULTB)
+static inline int32_t multiply_16tx16b(uint32_t a, uint32_t b)
+{
+  return (int32_t)(int16_t)(a >> 16) * (int16_t)b;
+}
+
+// (val >> rshift) saturated to bits, signed (SSAT with ASR)
+static inline int32_t signed_saturate_rshift(int32_t val, int bits, int rshift)
+{
+  int32_t v = val >> rshift, hi = (1 << (bits - 1)) - 1, lo = -(1 << (bits - 1));
+  return v > hi ? hi : (v < lo ? lo : v);
+}
+
+// a[31:16] * b[31:16] + a[15:0] * b[15:0], signed (SMUAD)
+static inline int32_t multiply_16tx16t_add_16bx16b(uint32_t a, uint32_t b)
+{
+  return (int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16) +
+         (int32_t)(int16_t)a * (int16_t)b;
+}
+
+#endif /* HOST_DSPINST_H_INCLUDED */
@@ -0,0 +1,21 @@
+/**
+  ******************************************************************************
+  * @file    sqrt_integer.h
+  * @brief   Host stand-in of the Teensy Audio integer square root
+  *
+  ******************************************************************************
+  *
+   */
+
+#ifndef HOST_SQRT_INTEGER_H_INCLUDED
+#define HOST_SQRT_INTEGER_H_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+
+static inline uint32_t sqrt_uint32_approx(uint32_t in)
+{
+  return (uint32_t)sqrt((double)in);
+}
+
+#endif /* HOST_SQRT_INTEGER_H_INCLUDED */
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    windows.h
+  * @brief   Host stand-in of the Teensy Audio windows.c tables used by
+  *          the 256 point analyzers
+  *
+  ******************************************************************************
+  *
+  * Same formulas of windows.c, generated once: include it in one test
+  * only, it defines the tables.
+  *
+   */
+
+#ifndef HOST_WINDOWS_H_INCLUDED
+#define HOST_WINDOWS_H_INCLUDED
+
+#include <stdint.h>
+
+extern "C" {
+const int16_t AudioWindowHanning256[256] = {
+  0, 5, 20, 45, 80, 124, 179, 243, 317, 401, 495, 598,
+  711, 833, 965, 1106, 1257, 1416, 1585, 1763, 1949, 2145, 2349, 2561,
+  2782, 3011, 3249, 3494, 3747, 4008, 4276, 4552, 4834, 5124, 5421, 5724,
+  6034, 6350, 6672, 7000, 7334, 7673, 8018, 8367, 8722, 9081, 9444, 9812,
+  10184, 10559, 10938, 11321, 11706, 12094, 12485, 12879, 13274, 13671, 14070, 14470,
+  14872, 15274, 15677, 16081, 16484, 16888, 17291, 17694, 18096, 18497, 18897, 19295,
+  19691, 20085, 20477, 20867, 21254, 21638, 22019, 22396, 22770, 23139, 23505, 23866,
+  24223, 24575, 24922, 25264, 25601, 25932, 26257, 26576, 26889, 27195, 27495, 27789,
+  28075, 28354, 28626, 28891, 29148, 29397, 29638, 29871, 30096, 30313, 30521, 30721,
+  30912, 31094, 31267, 31432, 31587, 31732, 31869, 31996, 32114, 32222, 32320, 32409,
+  32488, 32557, 32617, 32666, 32706, 32736, 32756, 32766, 32766, 32756, 32736, 32706,
+  32666, 32617, 32557, 32488, 32409, 32320, 32222, 32114, 31996, 31869, 31732, 31587,
+  31432, 31267, 31094, 30912, 30721, 30521, 30313, 30096, 29871, 29638, 29397, 29148,
+  28891, 28626, 28354, 28075, 27789, 27495, 27195, 26889, 26576, 26257, 25932, 25601,
+  25264, 24922, 24575, 24223, 23866, 23505, 23139, 22770, 22396, 22019, 21638, 21254,
+  20867, 20477, 20085, 19691, 19295, 18897, 18497, 18096, 17694, 17291, 16888, 16484,
+  16081, 15677, 15274, 14872, 14470, 14070, 13671, 13274, 12879, 12485, 12094, 11706,
+  11321, 10938, 10559, 10184, 9812, 9444, 9081, 8722, 8367, 8018, 7673, 7334,
+  7000, 6672, 6350, 6034, 5724, 5421, 5124, 4834, 4552, 4276, 4008, 3747,
+  3494, 3249, 3011, 2782, 2561, 2349, 2145, 1949, 1763, 1585, 1416, 1257,
+  1106, 965, 833, 711, 598, 495, 401, 317, 243, 179, 124, 80,
+  45, 20, 5, 0,
+};
+
+const int16_t AudioWindowBlackmanNuttall256[256] = {
+  12, 12, 13, 15, 18, 22, 26, 32, 38, 46, 54, 64,
+  76, 89, 103, 119, 137, 158, 180, 205, 232, 262, 295, 331,
+  371, 414, 461, 512, 567, 627, 691, 761, 836, 916, 1002, 1095,
+  1193, 1299, 1411, 1531, 1658, 1793, 1935, 2086, 2246, 2414, 2592, 2778,
+  2974, 3180, 3396, 3621, 3857, 4104, 4361, 4628, 4907, 5196, 5496, 5808,
+  6130, 6464, 6808, 7164, 7530, 7907, 8295, 8694, 9103, 9522, 9951, 10390,
+  10839, 11296, 11762, 12237, 12719, 13209, 13707, 14210, 14720, 15236, 15756, 16281,
+  16810, 17341, 17875, 18411, 18948, 19486, 20023, 20559, 21093, 21624, 22152, 22676,
+  23195, 23708, 24214, 24713, 25203, 25685, 26157, 26618, 27067, 27504, 27929, 28340,
+  28736, 29117, 29483, 29832, 30164, 30478, 30774, 31051, 31309, 31548, 31766, 31963,
+  32140, 32295, 32428, 32540, 32629, 32697, 32742, 32764, 32764, 32742, 32697, 32629,
+  32540, 32428, 32295, 32140, 31963, 31766, 31548, 31309, 31051, 30774, 30478, 30164,
+  29832, 29483, 29117, 28736, 28340, 27929, 27504, 27067, 26618, 26157, 25685, 25203,
+  24713, 24214, 23708, 23195, 22676, 22152, 21624, 21093, 20559, 20023, 19486, 18948,
+  18411, 17875, 17341, 16810, 16281, 15756, 15236, 14720, 14210, 13707, 13209, 12719,
+  12237, 11762, 11296, 10839, 10390, 9951, 9522, 9103, 8694, 8295, 7907, 7530,
+  7164, 6808, 6464, 6130, 5808, 5496, 5196, 4907, 4628, 4361, 4104, 3857,
+  3621, 3396, 3180, 2974, 2778, 2592, 2414, 2246, 2086, 1935, 1793, 1658,
+  1531, 1411, 1299, 1193, 1095, 1002, 916, 836, 761, 691, 627, 567,
+  512, 461, 414, 371, 331, 295, 262, 232, 205, 180, 158, 137,
+  119, 103, 89, 76, 64, 54, 46, 38, 32, 26, 22, 18,
+  15, 13, 12, 12,
+};
+}
+
+#endif /* HOST_WINDOWS_H_INCLUDED */
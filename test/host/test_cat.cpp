@@ -0,0 +1,211 @@
+/**
+  ******************************************************************************
+  * @file    test_cat.cpp
+  * @brief   CAT parser: scripted sessions replayed through a port stub
+  *
+  ******************************************************************************
+  *
+  * The radio side is a model: the controls only move their index and the
+  * label, as the real ones do before touching the hardware.
+  *
+   */
+
+#include <Arduino.h>
+#include <string>
+#include "host_test.h"
+
+//************************************************************************
+//      Radio side seen by RDSP_cat.h
+//************************************************************************
+constexpr const char *MODE_LABELS[]   = {"CW N", "CW", "USB", "LSB", "AM", "SAM", "RTTY"};
+constexpr const char *FILTER_LABELS[] = {"500 Hz", "2.1 kHz", "2.7 kHz", "3.1 kHz", "3.9 kHz"};
+constexpr const char *NR_LABELS[]     = {"", "NOTCH", "DNR 1", "DNR 2", "DNR 3", "DNR 4", "Q NTCH", "Q DNR"};
+
+static const long   topFreq = 30000000;
+static const long   bottomFreq = 30000;
+volatile uint32_t   vfoFreq = 7050000;
+double              dFLoCut = 300.0;
+double              dFHiCut = 4000.0;
+#define             MIN_LOW 0.0
+#define             MAX_LOW 700.0
+#define             MIN_HI 800.0
+#define             MAX_HI 4000.0
+
+int                 mndx = 3, fndx = 2, nrndx = 0;
+const char         *newMode = MODE_LABELS[3];
+const char         *newFilter = FILTER_LABELS[2];
+const char         *newNR = NR_LABELS[0];
+
+#define SMETER_DBM_MIN  (-127.0)
+#define SMETER_DBM_S9   (-73.0)
+float               smeterAvgDbm = SMETER_DBM_MIN;
+
+int                 applyFreqCalls = 0;
+int                 filterCalls = 0;
+
+void applyFreq() { applyFreqCalls++; }
+void tuningMode() { newMode = MODE_LABELS[mndx]; }
+void filterMode() { newFilter = FILTER_LABELS[fndx]; }
+void setNRMode() { nrndx = (nrndx + 1) % 8; newNR = NR_LABELS[nrndx]; }
+void reInitializeFilter(double, double) { filterCalls++; }
+void showPBT() {}
+
+// Page 0 is long, more than one USB buffer; page 1 is empty
+bool Telemetry_Report(int page, Print &out)
+{
+  if (page == 0) {
+    for (int i = 0; i < 20; i++) out.printf("line %02d of the debug page\n", i);
+    return true;
+  }
+  return page == 1;
+}
+
+#include "../../src/RadioDSP_SDR_RX/RDSP_cat.h"
+
+//************************************************************************
+//      Port stub: input script, output captured
+//************************************************************************
+class HostPort : public Stream
+{
+public:
+  std::string in;
+  size_t      pos = 0;
+  std::string out;
+  int         room = 64;     // free space of the USB transmit buffer
+
+  int available() override { return (int)(in.size() - pos); }
+  int read() override { return pos < in.size() ? (uint8_t)in[pos++] : -1; }
+  int peek() override { return pos < in.size() ? (uint8_t)in[pos] : -1; }
+  size_t write(uint8_t b) override { out += (char)b; return 1; }
+  int availableForWrite() override { return room; }
+};
+
+HostPort port;
+
+// Feed a script, poll until it is consumed, return what was answered
+static std::string session(const char *script)
+{
+  port.in = script;
+  port.pos = 0;
+  port.out.clear();
+  while (Cat_Ready()) Cat_Poll();
+  return port.out;
+}
+
+int main()
+{
+  initCat(port);
+
+  // FA: read, set, out of range, lower case
+  CHECK_STR(session("FA;").c_str(), "FA00007050000;");
+  CHECK_STR(session("FA00014074000;FA;").c_str(), "FA00014074000;");
+  CHECK(vfoFreq == 14074000 && applyFreqCalls == 1);
+  CHECK_STR(session("FA00000001000;").c_str(), "?;");
+  CHECK_STR(session("FA00031000000;").c_str(), "?;");
+  CHECK_STR(session("fa00007000000;fa;").c_str(), "FA00007000000;");
+  CHECK(vfoFreq == 7000000);
+
+  // MD: Kenwood numbers to the MODE_LABELS order, FM is not available
+  CHECK_STR(session("MD;").c_str(), "MD1;");
+  CHECK_STR(session("MD2;MD;").c_str(), "MD2;");
+  CHECK(strcmp(newMode, "USB") == 0);
+  CHECK_STR(session("MD7;MD;").c_str(), "MD3;");
+  CHECK(strcmp(newMode, "CW") == 0);
+  CHECK_STR(session("MD4;").c_str(), "?;");
+  CHECK_STR(session("MD10;").c_str(), "?;");
+
+  // FW: the narrowest filter not below the request
+  CHECK_STR(session("FW;").c_str(), "FW2700;");
+  CHECK_STR(session("FW0500;FW;").c_str(), "FW0500;");
+  CHECK_STR(session("FW3000;FW;").c_str(), "FW3100;");
+  CHECK_STR(session("FW9999;FW;").c_str(), "FW3900;");
+  CHECK_STR(session("FW500;").c_str(), "?;");
+
+  // IF: TS-2000 layout, 38 characters
+  session("MD2;");
+  std::string answer = session("IF;");
+  CHECK_STR(answer.c_str(), "IF00007000000     +00000000002000000 ;");
+  CHECK(answer.size() == 38);
+
+  // SM: S0 = 0, S9 = 15, S9+60 = 30, clamped
+  smeterAvgDbm = SMETER_DBM_S9;
+  CHECK_STR(session("SM;").c_str(), "SM00015;");
+  smeterAvgDbm = SMETER_DBM_S9 + 60;
+  CHECK_STR(session("SM0;").c_str(), "SM00030;");
+  smeterAvgDbm = -150;
+  CHECK_STR(session("SM;").c_str(), "SM00000;");
+  CHECK_STR(session("SM1;").c_str(), "?;");
+
+  // PB: both cuts in range
+  CHECK_STR(session("PB02003000;PB;").c_str(), "PB02003000;");
+  CHECK(filterCalls == 1);
+  CHECK_STR(session("PB08003000;").c_str(), "?;");
+  CHECK_STR(session("PB02000500;").c_str(), "?;");
+  CHECK_STR(session("PB0200300;").c_str(), "?;");
+  CHECK(dFLoCut == 200 && dFHiCut == 3000);
+
+  // NR: index of NR_LABELS
+  CHECK_STR(session("NR;").c_str(), "NR0;");
+  CHECK_STR(session("NR3;NR;").c_str(), "NR3;");
+  CHECK(strcmp(newNR, "DNR 2") == 0);
+  CHECK_STR(session("NR0;NR;").c_str(), "NR0;");
+  CHECK_STR(session("NR7;NR;").c_str(), "NR7;");
+  CHECK_STR(session("NR8;").c_str(), "?;");
+
+  // Malformed, unknown, empty: one "?;" each, the parser goes on
+  CHECK_STR(session("F;ZZ;;FA1x;").c_str(), "?;?;?;?;");
+  CHECK_STR(session("\r\nFA;\r\n").c_str(), "FA00007000000;");
+  CHECK_STR(session("F\xE9;FA;").c_str(), "?;FA00007000000;");
+
+  // Overflow: discarded up to the next ';', then back to normal
+  CHECK_STR(session("FA0000000000000000000000000000000000;FA;").c_str(), "?;FA00007000000;");
+  CHECK(vfoFreq == 7000000);
+
+  // A command split across polls
+  CHECK_STR(session("FA000140").c_str(), "");
+  CHECK_STR(session("74000;FA;").c_str(), "FA00014074000;");
+
+  // At most CAT_MAX_BYTES per poll
+  std::string many;
+  for (int i = 0; i < 40; i++) many += "FA;";
+  port.in = many;
+  port.pos = 0;
+  port.out.clear();
+  port.room = 1000;
+  Cat_Poll();
+  CHECK(port.pos == CAT_MAX_BYTES);
+  while (Cat_Ready()) Cat_Poll();
+  CHECK(port.out.size() == 40 * 14);
+
+  // Port full: the answer is dropped and counted, nothing waits
+  uint32_t dropped = catDropped;
+  port.room = 4;
+  CHECK_STR(session("FA;").c_str(), "");
+  CHECK(catDropped == dropped + 1);
+  port.room = 64;
+
+  // DB: the page goes out a piece per poll, closed by DBn; and the
+  // answers asked meanwhile follow it
+  port.room = 64;
+  port.in = "DB;FA;";
+  port.pos = 0;
+  port.out.clear();
+  int polls = 0;
+  while (Cat_Ready()) {
+    Cat_Poll();
+    polls++;
+  }
+  std::string page;
+  for (int i = 0; i < 20; i++) {
+    char line[40];
+    snprintf(line, sizeof(line), "line %02d of the debug page\n", i);
+    page += line;
+  }
+  CHECK_STR(port.out.c_str(), (page + "DB0;FA00014074000;").c_str());
+  CHECK(polls > 1);
+  CHECK_STR(session("DB1;").c_str(), "DB1;");
+  CHECK_STR(session("DB2;").c_str(), "?;");
+  CHECK_STR(session("DB12;").c_str(), "?;");
+
+  return testResult("test_cat");
+}
@@ -0,0 +1,178 @@
+/**
+  ******************************************************************************
+  * @file    test_fft256iq.cpp
+  * @brief   Float analyzer with deferred FFT against the q15 one in the ISR
+  *
+  ******************************************************************************
+  *
+  * AudioAnalyzeFFT256IQ does window, FFT and average in update();
+  * AudioAnalyzeFFT256IQF only snapshots the blocks in update() and posts
+  * the rest on fftiqWorkQueue(), run here as loop() does. The same tone
+  * in both must land in the same bin at the same level (both output
+  * in the units of the q15 analyzer), the float one must keep a weak
+  * carrier the q15 FFT loses under its truncation floor, and a frame
+  * must only be published by runDeferred(), one job at time.
+  *
+  * The polyphase filter bank of the q15 analyzer is measured against
+  * its window: the level of a tone between two bins and the leakage of
+  * a strong tone on the far bins.
+  *
+  * The FFTs are the models of the arm_math.h stub. The times printed are
+  * of the host build, an indication only: on the radio both costs are on
+  * CAT debug page 3 (DB3;), cyclesPerFFT() and isrCycles().
+  *
+   */
+
+#include <Arduino.h>
+#include <chrono>
+#include "host_test.h"
+#include "../../src/RadioDSP_SDR_RX/analyze_fft256iq.cpp"
+#include "../../src/RadioDSP_SDR_RX/analyze_fft256iqf.cpp"
+#include <windows.h>
+
+#define DB_OFFSET  (40 * 256)     // 1 LSB of |X|^2 of the q15 FFT = 40 dB
+
+static audio_block_t blockI, blockQ;
+static double        tonePhase = 0.0;
+static double        isrNs = 0.0, loopNs = 0.0;
+
+// one block of the tone at bin k, amplitude a of full scale, to the
+// analyzer; the deferred jobs run after it as in loop()
+template <class A>
+static void feed(A &fft, double k, double a)
+{
+  double step = 2.0 * M_PI * k / 256.0;
+  for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+    blockI.data[i] = (int16_t)lround(a * 32767.0 * cos(tonePhase));
+    blockQ.data[i] = (int16_t)lround(a * 32767.0 * sin(tonePhase));
+    tonePhase = fmod(tonePhase + step, 2.0 * M_PI);
+  }
+  hostInput[0] = &blockI;
+  hostInput[1] = &blockQ;
+  auto t0 = std::chrono::steady_clock::now();
+  fft.update();
+  auto t1 = std::chrono::steady_clock::now();
+  fftiqWorkQueue().runDeferred();
+  auto t2 = std::chrono::steady_clock::now();
+  isrNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+  loopNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+}
+
+template <class A>
+static void setup(A &fft)
+{
+  fft.windowFunction(AudioWindowHanning256);
+  fft.averageTogether(1);
+  fft.outputDb(true, DB_OFFSET);
+}
+
+// the frame after a few blocks of the tone
+template <class A>
+static void frameOf(A &fft, double k, double a, uint16_t *frame)
+{
+  for (int n = 0; n < 8; n++) feed(fft, k, a);
+  memcpy(frame, fft.lockFrame(), 256 * sizeof(uint16_t));
+  fft.unlockFrame();
+}
+
+static int peakBin(const uint16_t *frame)
+{
+  int peak = 0;
+  for (int i = 1; i < 256; i++)
+    if (frame[i] > frame[peak]) peak = i;
+  return peak;
+}
+
+int main()
+{
+  static AudioAnalyzeFFT256IQ  fftQ15;
+  static AudioAnalyzeFFT256IQF fftF32;
+  static uint16_t frameQ15[256], frameF32[256];
+  setup(fftQ15);
+  setup(fftF32);
+
+  // Deferred: update() only posts, runDeferred() publishes
+  FFTIQWorkQueue &queue = fftiqWorkQueue();
+  uint32_t seq = fftF32.frameSequence();
+  hostInput[0] = &blockI; hostInput[1] = &blockQ;
+  fftF32.update();                                  // first block, no frame yet
+  CHECK(!queue.pending());
+  hostInput[0] = &blockI; hostInput[1] = &blockQ;
+  fftF32.update();
+  CHECK(queue.pending());
+  CHECK(fftF32.frameSequence() == seq);
+  hostInput[0] = &blockI; hostInput[1] = &blockQ;
+  fftF32.update();                                  // loop() late: this one is dropped
+  CHECK(queue.runDeferred() == 1);
+  CHECK(fftF32.frameSequence() == seq + 1);
+  CHECK(!queue.pending());
+  CHECK(queue.droppedJobs() == 0);
+
+  // The same tone in both: same bin, same level
+  static const double bins[] = {20.0, -40.0, 63.0, -100.0};
+  for (unsigned t = 0; t < sizeof(bins) / sizeof(bins[0]); t++) {
+    frameOf(fftQ15, bins[t], 0.5, frameQ15);
+    frameOf(fftF32, bins[t], 0.5, frameF32);
+    int expected = 127 - (int)bins[t];
+    int peak = peakBin(frameF32);
+    printf("bin %+4.0f: q15 peak %d, float peak %d, level q15 %.2f float %.2f dB\n", bins[t],
+           peakBin(frameQ15), peak, frameQ15[peak] / 256.0, frameF32[peak] / 256.0);
+    CHECK(peakBin(frameQ15) == expected && peak == expected);
+    for (int i = peak - 1; i <= peak + 1; i++)
+      CHECK(abs(frameQ15[i] - frameF32[i]) < 128);    // 0.5 dB, the window skirts too
+  }
+
+  // Weak carriers: the float level follows the input down to the 16 bit
+  // LSB, the q15 one leaves it where the FFT truncation takes over
+  for (int dB = -60; dB >= -90; dB -= 10) {
+    double a = pow(10.0, dB / 20.0);
+    double expected = 20 * log10(a * 32767.0 * 0.5) + DB_OFFSET / 256.0;   // Hanning gain 1/2
+    frameOf(fftQ15, 30.0, a, frameQ15);
+    frameOf(fftF32, 30.0, a, frameF32);
+    double q15Err = frameQ15[97] / 256.0 - expected, f32Err = frameF32[97] / 256.0 - expected;
+    printf("%d dBFS carrier: expected %.1f dB, q15 %+.1f dB, float %+.1f dB off\n", dB, expected, q15Err, f32Err);
+    CHECK(peakBin(frameF32) == 97 && fabs(f32Err) < 1.0);
+    if (dB <= -70) CHECK(fabs(q15Err) > 3.0);
+  }
+
+  // Polyphase filter bank against the window, same q15 analyzer: a tone
+  // on a bin and between two bins, the level lost between the bins
+  // (scalloping) and the worst leakage 2 or more bins away from them
+  double scallop[2], leakage[2], pfbNs[2];
+  for (int pfb = 0; pfb < 2; pfb++) {
+    fftQ15.polyphase(pfb);
+    frameOf(fftQ15, 20.0, 0.5, frameQ15);
+    frameOf(fftQ15, 20.0, 0.5, frameQ15);           // the filter bank ring is full
+    CHECK(peakBin(frameQ15) == 107);
+    double onBin = frameQ15[107] / 256.0;
+    frameOf(fftQ15, 20.5, 0.5, frameQ15);            // between bins 106 and 107
+    scallop[pfb] = onBin - frameQ15[107] / 256.0;
+    CHECK(abs(frameQ15[106] - frameQ15[107]) < 128);
+    int worst = 0;
+    for (int i = 0; i < 256; i++)
+      if ((i < 105 || i > 108) && frameQ15[i] > frameQ15[worst]) worst = i;
+    leakage[pfb] = (frameQ15[worst] - frameQ15[107]) / 256.0;
+    isrNs = loopNs = 0.0;
+    for (int n = 0; n < 1000; n++) feed(fftQ15, 20.0, 0.5);
+    pfbNs[pfb] = isrNs / 1000;
+  }
+  fftQ15.polyphase(false);
+  printf("Hanning: scalloping %.1f dB, leakage %.1f dB; filter bank: scalloping %.1f dB, leakage %.1f dB\n",
+         scallop[0], leakage[0], scallop[1], leakage[1]);
+  printf("per block: q15 ISR with window %.0f ns, with filter bank %.0f ns (host)\n", pfbNs[0], pfbNs[1]);
+  CHECK(scallop[0] > 1.0 && scallop[0] < 2.0);       // Hanning: 1.42 dB
+  CHECK(scallop[1] < 3.5);
+  CHECK(leakage[1] < -60.0 && leakage[1] < leakage[0] - 30.0);   // down to the q15 FFT spurs
+
+  // Cost, host build
+  isrNs = loopNs = 0.0;
+  for (int n = 0; n < 1000; n++) feed(fftQ15, 20.0, 0.5);
+  double q15Isr = isrNs / 1000;
+  isrNs = loopNs = 0.0;
+  for (int n = 0; n < 1000; n++) feed(fftF32, 20.0, 0.5);
+  printf("per block: q15 ISR %.0f ns, float ISR %.0f ns + loop() %.0f ns (host)\n",
+         q15Isr, isrNs / 1000, loopNs / 1000);
+  CHECK(queue.droppedJobs() == 0);
+
+  return testResult("test_fft256iq");
+}
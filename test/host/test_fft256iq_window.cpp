@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    test_fft256iq_window.cpp
+  * @brief   Fused copy + window kernel of AudioAnalyzeFFT256IQ against the
+  *          two pass code it replaced
+  *
+  ******************************************************************************
+  *
+  * Both paths fill the 256 complex points of one FFT from two blocks of
+  * I and Q; the buffers must be bit exact, on random blocks and on the
+  * full scale corners (-32768 * -32768 is the one product whose >> 15
+  * does not fit 16 bits: both keep the low half word).
+  *
+   */
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include "host_test.h"
+
+#define AUDIO_BLOCK_SAMPLES 128
+#include <utility/dspinst.h>
+#include "../../src/RadioDSP_SDR_RX/analyze_fft256iq_kernels.h"
+
+static int16_t prevI[AUDIO_BLOCK_SAMPLES] __attribute__ ((aligned (4)));
+static int16_t prevQ[AUDIO_BLOCK_SAMPLES] __attribute__ ((aligned (4)));
+static int16_t curI[AUDIO_BLOCK_SAMPLES] __attribute__ ((aligned (4)));
+static int16_t curQ[AUDIO_BLOCK_SAMPLES] __attribute__ ((aligned (4)));
+static int16_t window[256] __attribute__ ((aligned (4)));
+static int16_t fused[512] __attribute__ ((aligned (4)));
+static int16_t reference[512] __attribute__ ((aligned (4)));
+
+static int16_t randomSample()
+{
+  return (int16_t)(rand() & 0xFFFF);
+}
+
+// the two calls of AudioAnalyzeFFT256IQ::update(), both ways
+static bool samePaths()
+{
+  copy_window_to_fft_buffer(fused, prevI, prevQ, window);
+  copy_window_to_fft_buffer(fused + 256, curI, curQ, window + AUDIO_BLOCK_SAMPLES);
+
+  copy_to_fft_buffer(reference, prevI, prevQ);
+  copy_to_fft_buffer(reference + 256, curI, curQ);
+  apply_window_to_fft_buffer(reference, window);
+
+  return memcmp(fused, reference, sizeof(fused)) == 0;
+}
+
+static void fill(int16_t *block, int16_t v)
+{
+  for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) block[i] = v;
+}
+
+int main()
+{
+  // Random blocks and random windows, any 16 bit value
+  srand(1);
+  bool bRandom = true;
+  for (int run = 0; run < 2000; run++) {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+      prevI[i] = randomSample(); prevQ[i] = randomSample();
+      curI[i] = randomSample();  curQ[i] = randomSample();
+    }
+    for (int i = 0; i < 256; i++) window[i] = randomSample();
+    bRandom &= samePaths();
+  }
+  CHECK(bRandom);
+
+  // A real window (Hanning, as AudioWindowHanning256) on random blocks
+  for (int i = 0; i < 256; i++)
+    window[i] = (int16_t)((0.5 - 0.5 * cos(2 * M_PI * i / 256)) * 32767.0);
+  bool bHanning = true;
+  for (int run = 0; run < 200; run++) {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+      prevI[i] = randomSample(); prevQ[i] = randomSample();
+      curI[i] = randomSample();  curQ[i] = randomSample();
+    }
+    bHanning &= samePaths();
+  }
+  CHECK(bHanning);
+
+  // Full scale corners, every combination of sample and window
+  static const int16_t corners[] = {-32768, -32767, -1, 0, 1, 32767};
+  const int n = sizeof(corners) / sizeof(corners[0]);
+  for (int s = 0; s < n; s++) {
+    for (int w = 0; w < n; w++) {
+      fill(prevI, corners[s]); fill(prevQ, corners[n - 1 - s]);
+      fill(curI, corners[s]);  fill(curQ, corners[(s + 2) % n]);
+      for (int i = 0; i < 256; i++) window[i] = corners[w];
+      CHECK(samePaths());
+    }
+  }
+
+  // Alternating extremes inside a word: the two lanes kept apart
+  for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+    prevI[i] = (i & 1) ? 32767 : -32768;  prevQ[i] = (i & 1) ? -32768 : 32767;
+    curI[i] = (i & 2) ? -32768 : 1;       curQ[i] = (i & 2) ? -1 : 32767;
+  }
+  for (int i = 0; i < 256; i++) window[i] = (i & 1) ? -32768 : 32767;
+  CHECK(samePaths());
+
+  return testResult("test_fft256iq_window");
+}
@@ -0,0 +1,200 @@
+/**
+  ******************************************************************************
+  * @file    test_fftiq.cpp
+  * @brief   AudioAnalyzeFFTIQ<N>: where a tone lands in the published frame
+  *
+  ******************************************************************************
+  *
+  * A complex tone exp(+j 2pi f t) is fed a block at a time through the
+  * AudioStream stub and the FFT is the double precision one of the
+  * arm_math.h stub. The frame has DC at bin N/2 - 1 and the positive
+  * frequencies on the lower bins: the peak must be at
+  * N/2 - 1 - round(f / binWidth()).
+  *
+  * Zoom: the NCO moves the offset to DC and CIC + FIR decimate, so a
+  * tone at offset + delta must land at N/2 - 1 - round(delta / binWidth())
+  * with binWidth() = fs / (decimation * N). setOffset() must retune
+  * without emptying the ring and a disabled analyzer must only release
+  * its blocks.
+  *
+   */
+
+#include <Arduino.h>
+#include "host_test.h"
+#include "../../src/RadioDSP_SDR_RX/analyze_fftiq.h"
+
+static audio_block_t blockI, blockQ;
+static double        tonePhase = 0.0;
+
+// one block of the tone, amplitude a of full scale, to the analyzer
+template <uint16_t N>
+static void feed(AudioAnalyzeFFTIQ<N> &fft, double f, double a)
+{
+  double step = 2.0 * M_PI * f / AUDIO_SAMPLE_RATE_EXACT;
+  for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+    blockI.data[i] = (int16_t)lround(a * 32767.0 * cos(tonePhase));
+    blockQ.data[i] = (int16_t)lround(a * 32767.0 * sin(tonePhase));
+    tonePhase = fmod(tonePhase + step, 2.0 * M_PI);
+  }
+  hostInput[0] = &blockI;
+  hostInput[1] = &blockQ;
+  fft.update();
+}
+
+// blocks until a new frame is published, at most max
+template <uint16_t N>
+static int feedFrame(AudioAnalyzeFFTIQ<N> &fft, double f, double a, int max)
+{
+  uint32_t seq = fft.frameSequence();
+  for (int n = 1; n <= max; n++) {
+    feed(fft, f, a);
+    if (fft.frameSequence() != seq) return n;
+  }
+  return -1;
+}
+
+template <uint16_t N>
+static int peakBin(AudioAnalyzeFFTIQ<N> &fft)
+{
+  const uint16_t *frame = fft.lockFrame();
+  int peak = 0;
+  for (int i = 1; i < N; i++)
+    if (frame[i] > frame[peak]) peak = i;
+  fft.unlockFrame();
+  return peak;
+}
+
+// dB of the peak above the median of the frame
+template <uint16_t N>
+static float peakOverFloor(AudioAnalyzeFFTIQ<N> &fft)
+{
+  static uint16_t sorted[2048];
+  const uint16_t *frame = fft.lockFrame();
+  memcpy(sorted, frame, N * sizeof(uint16_t));
+  fft.unlockFrame();
+  std::sort(sorted, sorted + N);
+  return (sorted[N - 1] - sorted[N / 2]) / 256.0;
+}
+
+template <uint16_t N>
+static int expectedBin(double f, float binHz)
+{
+  return N / 2 - 1 - (int)lround(f / binHz);
+}
+
+// Full band: tones on bin centers, both sides of DC
+template <uint16_t N>
+static void checkFullBand()
+{
+  static AudioAnalyzeFFTIQ<N> fft;
+  fft.windowFunction(FFTIQ_WINDOW_HANNING);
+  fft.setOverlap(FFTIQ_OVERLAP_50);
+  fft.averageMode(FFTIQ_AVG_EXP, 0);
+  fft.outputDb(true);
+
+  float binHz = fft.binWidth();
+  CHECK(fabs(binHz - AUDIO_SAMPLE_RATE_EXACT / N) < 1e-3);
+
+  static const int offsets[] = {1, 37, 100, N / 4, N / 2 - 3, -1, -60, -N / 4, -(N / 2 - 3)};
+  for (unsigned k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++) {
+    double f = offsets[k] * binHz;
+    // a full ring of the new tone
+    for (int n = 0; n < N / AUDIO_BLOCK_SAMPLES; n++) feed(fft, f, 0.5);
+    CHECK(feedFrame(fft, f, 0.5, N / AUDIO_BLOCK_SAMPLES) > 0);
+    int got = peakBin(fft);
+    CHECK(got == expectedBin<N>(f, binHz));
+    if (got != expectedBin<N>(f, binHz))
+      printf("N %d: %.1f Hz at bin %d, expected %d\n", N, f, got, expectedBin<N>(f, binHz));
+    CHECK(peakOverFloor(fft) > 40.0);
+  }
+
+  // the carrier of the radio, +TuningOffset (11 kHz) in the baseband
+  double fc = 11025.0;
+  for (int n = 0; n < N / AUDIO_BLOCK_SAMPLES + 2; n++) feed(fft, fc, 0.5);
+  CHECK(abs(peakBin(fft) - expectedBin<N>(fc, binHz)) <= 1);
+}
+
+// Zoom around an offset: tones on bin centers near the offset
+template <uint16_t N>
+static void checkZoom(uint8_t decim, double offset)
+{
+  static AudioAnalyzeFFTIQ<N> fft;
+  fft.windowFunction(FFTIQ_WINDOW_HANNING);
+  fft.setOverlap(FFTIQ_OVERLAP_50);
+  fft.averageMode(FFTIQ_AVG_EXP, 0);
+  fft.outputDb(true);
+  CHECK(fft.setZoom(decim, offset));
+  CHECK(fft.zoom() == decim);
+
+  float binHz = fft.binWidth();
+  CHECK(fabs(binHz - AUDIO_SAMPLE_RATE_EXACT / (decim * N)) < 1e-3);
+
+  // inside the FIR passband, fs / (4 decim) on each side
+  static const int offsets[] = {0, 5, 40, N / 8, -7, -N / 8};
+  int ring = N * decim / AUDIO_BLOCK_SAMPLES;
+  for (unsigned k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++) {
+    double delta = offsets[k] * binHz;
+    for (int n = 0; n < ring + 2; n++) feed(fft, offset + delta, 0.5);
+    CHECK(feedFrame(fft, offset + delta, 0.5, ring) > 0);
+    int got = peakBin(fft);
+    CHECK(got == expectedBin<N>(delta, binHz));
+    if (got != expectedBin<N>(delta, binHz))
+      printf("N %d x%d: offset %.1f + %.1f Hz at bin %d, expected %d\n",
+             N, decim, offset, delta, got, expectedBin<N>(delta, binHz));
+    CHECK(peakOverFloor(fft) > 40.0);
+  }
+}
+
+// setOffset(): the next frame comes after a hop, not a whole new ring
+static void checkRetune()
+{
+  static AudioAnalyzeFFTIQ<512> fft;
+  fft.windowFunction(FFTIQ_WINDOW_HANNING);
+  fft.setOverlap(FFTIQ_OVERLAP_50);
+  fft.averageMode(FFTIQ_AVG_EXP, 0);
+  fft.outputDb(true);
+  fft.setZoom(8, 11025.0);
+  for (int n = 0; n < 2 * 512 * 8 / AUDIO_BLOCK_SAMPLES; n++) feed(fft, 11025.0, 0.5);
+  CHECK(peakBin(fft) == 255);
+
+  uint32_t ffts = fft.fftsDone();
+  fft.setOffset(-11025.0);
+  int blocks = feedFrame(fft, -11025.0, 0.5, 64);
+  CHECK(blocks > 0 && blocks <= 256 * 8 / AUDIO_BLOCK_SAMPLES);
+  CHECK(fft.fftsDone() == ffts + 1);
+  // a ring later the new carrier is alone at DC
+  for (int n = 0; n < 512 * 8 / AUDIO_BLOCK_SAMPLES; n++) feed(fft, -11025.0, 0.5);
+  CHECK(peakBin(fft) == 255);
+  CHECK(fft.binWidth() == AUDIO_SAMPLE_RATE_EXACT / (8 * 512));
+
+  // disabled: blocks released unprocessed, no frames
+  fft.enable(false);
+  CHECK(!fft.isEnabled());
+  ffts = fft.fftsDone();
+  uint32_t seq = fft.frameSequence();
+  uint32_t released = hostReleased;
+  for (int n = 0; n < 200; n++) feed(fft, -11025.0, 0.5);
+  CHECK(fft.fftsDone() == ffts);
+  CHECK(fft.frameSequence() == seq);
+  CHECK(hostReleased == released + 400);
+
+  // enabled again: a full ring, then frames at the tone
+  fft.enable(true);
+  CHECK(feedFrame(fft, -11025.0, 0.5, 64) == 512 * 8 / AUDIO_BLOCK_SAMPLES);
+  CHECK(peakBin(fft) == 255);
+}
+
+int main()
+{
+  checkFullBand<512>();
+  checkFullBand<1024>();
+  checkFullBand<2048>();
+
+  checkZoom<512>(2, 11025.0);
+  checkZoom<512>(4, -5000.0);
+  checkZoom<512>(8, 11025.0);
+  checkZoom<1024>(8, 1500.0);
+  checkRetune();
+
+  return testResult("test_fftiq");
+}
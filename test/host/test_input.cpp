@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * @file    test_input.cpp
+  * @brief   Button debouncer traces, event queue and knob speed
+  *
+  ******************************************************************************
+  *
+  * The state machine is driven a millisecond at a time, as the timer does:
+  * the times of the events follow from INPUT_DEBOUNCE_MS, INPUT_LONG_MS
+  * and INPUT_REPEAT_MS, so they are checked exactly.
+  *
+   */
+
+#include <Arduino.h>
+#include "host_test.h"
+
+#define BUTTON_D2   2
+#define BUTTON_D3   6
+#define BUTTON_D6   3
+
+Encoder Position(4, 5);
+
+#include "../../src/RadioDSP_SDR_RX/RDSP_input.h"
+
+//************************************************************************
+//      Trace: level from..to (ms, inclusive), events with their time
+//************************************************************************
+struct TraceEvent { uint8_t ev; uint32_t ms; };
+
+static ButtonState  b;
+static uint32_t     traceMs = 0;
+static TraceEvent   got[32];
+static int          nGot = 0;
+
+static void resetTrace()
+{
+  b = {false, false, 0, 0, 0};
+  traceMs = 0;
+  nGot = 0;
+}
+
+static void level(boolean bDown, uint32_t toMs)
+{
+  while (traceMs < toMs) {
+    traceMs++;
+    uint8_t ev = Input_Step(b, bDown, traceMs, 1);
+    if (ev != BTN_EV_NONE && nGot < 32) got[nGot++] = {ev, traceMs};
+  }
+}
+
+static bool event(int i, uint8_t ev, uint32_t ms)
+{
+  return i < nGot && got[i].ev == ev && got[i].ms == ms;
+}
+
+static void resetQueue()
+{
+  inputHead = inputTail = 0;
+  inputOverflows = 0;
+}
+
+int main()
+{
+  // Short press: PRESS after the debounce time, RELEASE likewise
+  resetTrace();
+  level(false, 10);
+  level(true, 100);
+  level(false, 200);
+  CHECK(nGot == 2);
+  CHECK(event(0, BTN_EV_PRESS, 10 + INPUT_DEBOUNCE_MS));
+  CHECK(event(1, BTN_EV_RELEASE, 100 + INPUT_DEBOUNCE_MS));
+
+  // Contact bounce shorter than the debounce time is not seen
+  resetTrace();
+  for (int i = 0; i < 10; i++) {
+    level(true, traceMs + INPUT_DEBOUNCE_MS - 1);
+    level(false, traceMs + 1);
+  }
+  CHECK(nGot == 0);
+  CHECK(!b.bDown);
+
+  // Bouncing press: the time counts from the last bounce
+  resetTrace();
+  level(true, 3);
+  level(false, 4);
+  level(true, 6);
+  level(false, 7);
+  level(true, 50);
+  CHECK(nGot == 1);
+  CHECK(event(0, BTN_EV_PRESS, 7 + INPUT_DEBOUNCE_MS));
+
+  // A glitch while held does not release
+  level(false, 50 + INPUT_DEBOUNCE_MS - 1);
+  level(true, 100);
+  CHECK(nGot == 1);
+  CHECK(b.bDown);
+
+  // Held: LONG at INPUT_LONG_MS from the press, then REPEAT
+  resetTrace();
+  level(true, 1000);
+  level(false, 1100);
+  uint32_t press = INPUT_DEBOUNCE_MS;
+  uint32_t lng = press + INPUT_LONG_MS;
+  CHECK(event(0, BTN_EV_PRESS, press));
+  CHECK(event(1, BTN_EV_LONG, lng));
+  int repeats = (1000 - lng) / INPUT_REPEAT_MS;
+  CHECK(nGot == 2 + repeats + 1);
+  for (int i = 0; i < repeats; i++)
+    CHECK(event(2 + i, BTN_EV_REPEAT, lng + (i + 1) * INPUT_REPEAT_MS));
+  CHECK(event(nGot - 1, BTN_EV_RELEASE, 1000 + INPUT_DEBOUNCE_MS));
+
+  // A new press starts without LONG
+  level(true, 1200);
+  level(false, 1300);
+  CHECK(event(nGot - 2, BTN_EV_PRESS, 1100 + INPUT_DEBOUNCE_MS));
+  CHECK(event(nGot - 1, BTN_EV_RELEASE, 1200 + INPUT_DEBOUNCE_MS));
+
+  // Queue: FIFO, INPUT_QUEUE_SIZE - 1 events, the others counted
+  resetQueue();
+  CHECK(Input_GetEvent() == BTN_EV_NONE);
+  for (int i = 0; i < INPUT_QUEUE_SIZE + 2; i++)
+    Input_Post(BTN_EVENT(i % INPUT_BUTTONS, BTN_EV_PRESS + i % 4));
+  CHECK(inputOverflows == 3);
+  for (int i = 0; i < INPUT_QUEUE_SIZE - 1; i++)
+    CHECK(Input_GetEvent() == BTN_EVENT(i % INPUT_BUTTONS, BTN_EV_PRESS + i % 4));
+  CHECK(Input_GetEvent() == BTN_EV_NONE);
+
+  // ... and across the wrap of the indexes
+  bool bOrder = true;
+  for (int i = 0; i < 100; i++) {
+    Input_Post(BTN_EVENT(BTN_RIGHT, BTN_EV_REPEAT));
+    Input_Post(BTN_EVENT(BTN_MENU, BTN_EV_LONG));
+    bOrder &= Input_GetEvent() == BTN_EVENT(BTN_RIGHT, BTN_EV_REPEAT);
+    bOrder &= Input_GetEvent() == BTN_EVENT(BTN_MENU, BTN_EV_LONG);
+  }
+  CHECK(bOrder);
+  CHECK(inputOverflows == 3);
+  CHECK(BTN_EVENT_BUTTON(BTN_EVENT(BTN_RIGHT, BTN_EV_RELEASE)) == BTN_RIGHT);
+  CHECK(BTN_EVENT_TYPE(BTN_EVENT(BTN_RIGHT, BTN_EV_RELEASE)) == BTN_EV_RELEASE);
+
+  // Sampler: the pins (LOW = pressed) to events of the right button
+  for (int i = 0; i < INPUT_BUTTONS; i++) hostPins[inputPins[i]] = HIGH;
+  initInput();
+  resetQueue();
+  hostPins[BUTTON_D3] = LOW;
+  for (int i = 0; i < INPUT_DEBOUNCE_MS; i++) Input_Sample();
+  CHECK(Input_IsDown(BTN_LEFT));
+  CHECK(!Input_IsDown(BTN_MENU) && !Input_IsDown(BTN_RIGHT));
+  CHECK(Input_GetEvent() == BTN_EVENT(BTN_LEFT, BTN_EV_PRESS));
+  CHECK(Input_GetEvent() == BTN_EV_NONE);
+  hostPins[BUTTON_D3] = HIGH;
+  for (int i = 0; i < INPUT_DEBOUNCE_MS; i++) Input_Sample();
+  CHECK(Input_GetEvent() == BTN_EVENT(BTN_LEFT, BTN_EV_RELEASE));
+
+  // Knob: position every sample, speed settles on the counts per second
+  for (int i = 0; i < 2000; i++) {
+    hostKnob += 2;
+    Input_Sample();
+  }
+  CHECK(encCount == hostKnob);
+  CHECK(encVelocity > 1900 && encVelocity <= 2000);
+  for (int i = 0; i < 1000; i++) Input_Sample();
+  CHECK(encVelocity < 100);
+
+  return testResult("test_input");
+}
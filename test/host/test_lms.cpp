@@ -0,0 +1,156 @@
+/**
+  ******************************************************************************
+  * @file    test_lms.cpp
+  * @brief   Fixed point NLMS (q15, bypass modes) against the float NLMS
+  *
+  ******************************************************************************
+  *
+  * A tone in white noise goes a block at a time through LMS_NoiseReduction
+  * (float) and LMS_NoiseReduction_q15 (DNR and notch). The tone in the
+  * output is found by projection on its sine and cosine over the last
+  * blocks; the rest is the noise. The q15 DNR must improve the SNR within
+  * 5 dB of the float one (16 bit coefficients adapt coarser), the q15
+  * notch must remove the tone, at every
+  * input level the headroom shift can meet and across level steps, and
+  * the q15 energy of the instance must never wrap.
+  *
+  * The CMSIS NLMS are modelled in the arm_math.h stub. The times printed
+  * are of the host build, an indication only: on the radio the cycles of
+  * both are on CAT debug page 3 (DB3;).
+  *
+   */
+
+#include <Arduino.h>
+#include <arm_math.h>
+#include <chrono>
+#include <random>
+#include "host_test.h"
+#include "../../src/RadioDSP_SDR_RX/RDSP_noise_reduction.h"
+
+#define BLOCK      128
+#define FS         44117.64706
+#define BLOCKS     600
+#define MEASURED   150      // last blocks, after the convergence
+
+struct Result { double snrIn, snrOut, tonePower, noisePower; };
+
+// tone power and residual power of y, tone of frequency f
+static Result measure(const std::vector<double> &y, double f)
+{
+  double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0, yy = 0;
+  for (size_t n = 0; n < y.size(); n++) {
+    double s = sin(2 * M_PI * f * n / FS), c = cos(2 * M_PI * f * n / FS);
+    ss += s * s; cc += c * c; sc += s * c;
+    ys += y[n] * s; yc += y[n] * c; yy += y[n] * y[n];
+  }
+  double det = ss * cc - sc * sc;
+  double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+  double tone = 0, resid = 0;
+  for (size_t n = 0; n < y.size(); n++) {
+    double t = a * sin(2 * M_PI * f * n / FS) + b * cos(2 * M_PI * f * n / FS);
+    tone += t * t;
+    resid += (y[n] - t) * (y[n] - t);
+  }
+  Result r = {0, 10 * log10(tone / resid), tone / y.size(), resid / y.size()};
+  return r;
+}
+
+enum Path { FLOAT_DNR, FLOAT_NOTCH, Q15_DNR, Q15_NOTCH };
+
+// amplitude per block (full scale 1.0), noise at noiseRatio of it
+static Result run(Path path, double f, const double *amp, double noiseRatio, double *ns = NULL)
+{
+  std::mt19937 gen(7);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::vector<double> in, out;
+  float32_t fbuf[BLOCK];
+  q15_t     qbuf[BLOCK];
+  double    phase = 0;
+
+  if (path == FLOAT_DNR || path == FLOAT_NOTCH) {
+    LMS_preset = LMS_PRESET_SSB;
+    Init_LMS_NR(15);
+  } else {
+    Init_LMS_NR_q15(15, path == Q15_NOTCH ? LMS_Q15_NOTCH : LMS_Q15_NR);
+  }
+  hostLmsEnergyWraps = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int b = 0; b < BLOCKS; b++) {
+    double x[BLOCK];
+    for (int n = 0; n < BLOCK; n++) {
+      x[n] = amp[b] * (sin(phase) + noiseRatio * noise(gen));
+      phase = fmod(phase + 2 * M_PI * f / FS, 2 * M_PI);
+      fbuf[n] = x[n];
+      qbuf[n] = (q15_t)__SSAT((int32_t)lround(x[n] * 32767.0), 16);
+    }
+    if (path == FLOAT_DNR || path == FLOAT_NOTCH) {
+      LMS_NoiseReduction(BLOCK, fbuf);
+      if (path == FLOAT_NOTCH) memcpy(fbuf, LMS_errsig1, sizeof(fbuf));
+    } else {
+      LMS_NoiseReduction_q15(BLOCK, qbuf);
+      for (int n = 0; n < BLOCK; n++) fbuf[n] = qbuf[n] / 32767.0;
+    }
+    if (b >= BLOCKS - MEASURED) {
+      for (int n = 0; n < BLOCK; n++) {
+        in.push_back(x[n] / amp[b]);
+        out.push_back(fbuf[n] / amp[b]);
+      }
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  if (ns) *ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / BLOCKS;
+
+  Result r = measure(out, f);
+  r.snrIn = measure(in, f).snrOut;
+  return r;
+}
+
+static void levels(double *amp, double a)
+{
+  for (int b = 0; b < BLOCKS; b++) amp[b] = a;
+}
+
+int main()
+{
+  static double amp[BLOCKS];
+  const double f = 1000.0, noiseRatio = 0.5;
+
+  // Float reference
+  levels(amp, 0.25);
+  double nsF32, nsQ15;
+  Result fd = run(FLOAT_DNR, f, amp, noiseRatio, &nsF32);
+  Result fn = run(FLOAT_NOTCH, f, amp, noiseRatio);
+  double floatGain = fd.snrOut - fd.snrIn;
+  double floatNotch = 10 * log10(fn.tonePower / 0.5);
+  printf("float: SNR %.1f -> %.1f dB, notch tone %.1f dB\n", fd.snrIn, fd.snrOut, floatNotch);
+  CHECK(floatGain > 6.0);
+  CHECK(floatNotch < -20.0);
+
+  // q15 at every level the headroom can meet: -40 dBFS to near full scale
+  static const double tested[] = {0.01, 0.03, 0.1, 0.25, 0.5, 0.8};
+  for (unsigned k = 0; k < sizeof(tested) / sizeof(tested[0]); k++) {
+    levels(amp, tested[k] / (1 + 2 * noiseRatio));
+    Result qd = run(Q15_DNR, f, amp, noiseRatio, k == 3 ? &nsQ15 : NULL);
+    uint32_t wrapsDnr = hostLmsEnergyWraps;
+    Result qn = run(Q15_NOTCH, f, amp, noiseRatio);
+    uint32_t wrapsNotch = hostLmsEnergyWraps;
+    double qNotch = 10 * log10(qn.tonePower / 0.5);
+    printf("q15 peak %.2f: SNR %.1f -> %.1f dB, notch tone %.1f dB, shift %d, energy wraps %u/%u\n",
+           tested[k], qd.snrIn, qd.snrOut, qNotch, LMS_q15_shift, wrapsDnr, wrapsNotch);
+    CHECK(wrapsDnr == 0 && wrapsNotch == 0);
+    CHECK(qd.snrOut - qd.snrIn > 6.0 && qd.snrOut - qd.snrIn > floatGain - 5.0);
+    CHECK(qNotch < -40.0);
+  }
+
+  // level steps of 12 dB every 50 blocks: the shift moves, no gain step
+  for (int b = 0; b < BLOCKS; b++) amp[b] = ((b / 50) & 1) ? 0.4 : 0.1;
+  Result qs = run(Q15_DNR, f, amp, noiseRatio);
+  printf("q15 level steps: SNR %.1f -> %.1f dB, energy wraps %u\n", qs.snrIn, qs.snrOut, hostLmsEnergyWraps);
+  CHECK(hostLmsEnergyWraps == 0);
+  CHECK(qs.snrOut - qs.snrIn > 4.0);
+
+  printf("block of %d: float NLMS %.0f ns, q15 NLMS %.0f ns (host)\n", BLOCK, nsF32, nsQ15);
+
+  return testResult("test_lms");
+}
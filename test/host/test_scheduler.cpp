@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    test_scheduler.cpp
+  * @brief   Loop scheduler on a simulated clock
+  *
+  ******************************************************************************
+  *
+  * The clock only moves when a task "runs" (by its cost) or when the loop
+  * is idle (by IDLE_STEP), so every number below is exact.
+  *
+   */
+
+#include <Arduino.h>
+#include "host_test.h"
+#include "../../src/RadioDSP_SDR_RX/RDSP_scheduler.h"
+
+#define IDLE_STEP 100
+
+static uint32_t simClock() { return hostMicros; }
+
+// Tasks: each one takes its cost in simulated time and logs its start
+struct SimTask { uint32_t cost; uint32_t runs; uint32_t lastStart; };
+SimTask simFast = {200, 0, 0}, simSlow = {1000, 0, 0}, simEvent = {50, 0, 0}, simHog = {0, 0, 0};
+char    order[64];
+int     orderLen = 0;
+bool    bEvent = false;
+int     idleCalls = 0;
+
+static void simRun(SimTask &t, char tag)
+{
+  t.runs++;
+  t.lastStart = hostMicros;
+  if (orderLen < (int)sizeof(order) - 1) order[orderLen++] = tag;
+  hostMicros += t.cost;
+}
+
+static void taskFast()  { simRun(simFast, 'f'); }
+static void taskSlow()  { simRun(simSlow, 's'); }
+static void taskEvent() { simRun(simEvent, 'e'); bEvent = false; }
+static void taskHog()   { simRun(simHog, 'h'); }
+static bool eventReady() { return bEvent; }
+static void idleHook()  { idleCalls++; }
+
+static void runFor(uint32_t micros)
+{
+  uint32_t end = hostMicros + micros;
+  while ((int32_t)(hostMicros - end) < 0) {
+    uint32_t before = hostMicros;
+    Sched_Run();
+    if (hostMicros == before) hostMicros += IDLE_STEP;
+  }
+}
+
+int main()
+{
+  // Periods, headroom: 200 us every 5 ms and 1000 us every 20 ms is 9%
+  hostMicros = 0;
+  Sched_Begin(simClock);
+  Sched_SetIdleHook(idleHook);
+  CHECK(Sched_Add("fast", taskFast, 5000, 5000, 1) == 0);
+  CHECK(Sched_Add("slow", taskSlow, 20000, 20000, 2) == 1);
+  CHECK(Sched_Add("event", taskEvent, 0, 0, 0, eventReady) == 2);
+  runFor(2000000);
+  CHECK(simFast.runs == 399);     // first release one period after the start
+  CHECK(simSlow.runs == 99);
+  CHECK(simEvent.runs == 0);
+  CHECK(schedTasks[0].late == 0 && schedTasks[1].late == 0);
+  CHECK(Sched_Headroom() >= 905 && Sched_Headroom() <= 915);
+  CHECK(idleCalls > 0 && schedIdlePasses == (uint32_t)idleCalls);
+
+  // Releases on the grid: the starts do not drift
+  CHECK(simFast.lastStart % 5000 < IDLE_STEP);
+
+  // Order in one pass: priority first, the event task is prio 0
+  orderLen = 0;
+  hostMicros = schedTasks[1].release;      // fast and slow both due
+  bEvent = true;
+  Sched_Run();
+  order[orderLen] = 0;
+  CHECK_STR(order, "efs");
+  CHECK(simEvent.runs == 1);
+
+  // An event task runs only when ready, once per pass
+  bEvent = false;
+  runFor(10000);
+  CHECK(simEvent.runs == 1);
+
+  // Earliest deadline first at the same priority
+  hostMicros = 0;
+  Sched_Begin(simClock);
+  simFast.runs = simSlow.runs = 0;
+  Sched_Add("slow", taskSlow, 10000, 8000, 1);
+  Sched_Add("fast", taskFast, 10000, 2000, 1);
+  orderLen = 0;
+  hostMicros = 10000;
+  Sched_Run();
+  order[orderLen] = 0;
+  CHECK_STR(order, "fs");
+
+  // A hog: the periodic task behind it starts late, the jitter is
+  // measured and a lost period restarts the grid from the start
+  hostMicros = 0;
+  Sched_Begin(simClock);
+  simFast.runs = 0;
+  simHog.cost = 30000;
+  Sched_Add("hog", taskHog, 50000, 0, 0);
+  Sched_Add("fast", taskFast, 5000, 10000, 1);
+  runFor(60000);
+  SchedTask &fast = schedTasks[1];
+  CHECK(fast.late == 1);
+  CHECK(simHog.lastStart == 50000);
+  CHECK(fast.maxJitterMicros == 30000);   // released at 50000, after the hog
+  CHECK((int32_t)(fast.release - (simHog.lastStart + 30000)) > 0);
+  CHECK(Sched_Headroom() == 1000);   // window not over yet
+  runFor(1000000);
+  CHECK(Sched_Headroom() < 450);
+
+  // Fixed table
+  hostMicros = 0;
+  Sched_Begin(simClock);
+  for (int i = 0; i < SCHED_MAX_TASKS; i++) CHECK(Sched_Add("t", taskFast, 1000, 0, 1) == i);
+  CHECK(Sched_Add("t", taskFast, 1000, 0, 1) == -1);
+
+  return testResult("test_scheduler");
+}
@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file    test_smoothing.cpp
+  * @brief   Spectrum smoothing kernel against a float reference
+  *
+  ******************************************************************************
+  *
+  * Frames of noise, carriers and steps in dB q8.8, as the analyzer gives
+  * them. The frequency filter (time shift 0) must be within 2 LSB of the
+  * float 5 taps FIR with the same normalized weights, and a flat spectrum
+  * must come out unchanged. The time filter must follow its integer
+  * recurrence exactly.
+  *
+  * The time of the kernel is printed next to the loop it replaced (0.7 /
+  * 0.3 / 0.15 weights, sqrt of the magnitude, 0.7 time LPF). On the host
+  * this is only an indication: the SIMD intrinsics are C here, on the
+  * radio smoothCycles is on CAT debug page 1 (DB1;).
+  *
+   */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include "host_test.h"
+#include "../../src/RadioDSP_SDR_RX/RDSP_spectrum_smooth.h"
+
+#define BINS  1024
+
+static uint16_t frame[BINS] __attribute__ ((aligned (4)));
+static int16_t  out[BINS];
+
+static void makeFrame(int seed)
+{
+  srand(seed);
+  for (int i = 0; i < BINS; i++) {
+    int v = 20 * 256 + rand() % (10 * 256);             // noise floor
+    if ((i + seed) % 97 == 0) v = 90 * 256;              // carriers
+    if (i > BINS / 2 && seed & 1) v += 30 * 256;         // a step
+    frame[i] = v;
+  }
+}
+
+// largest |kernel - float FIR| on the filtered bins, time shift 0
+static float maxError(int w0, int w1, int w2)
+{
+  float total = w0 + 2 * w1 + 2 * w2;
+  setSpectrumSmoothing(w0, w1, w2, 0);
+  smoothSpectrum_q15(frame, out, BINS);
+  float worst = 0;
+  for (int i = 2; i < BINS - 2; i++) {
+    float ref = (w0 * frame[i] + w1 * (frame[i - 1] + frame[i + 1]) +
+                 w2 * (frame[i - 2] + frame[i + 2])) / total;
+    worst = fmaxf(worst, fabsf(out[i] - ref));
+  }
+  return worst;
+}
+
+// The loop the kernel replaced, on the linear magnitude
+static float viewOld[BINS];
+static float view[BINS];
+
+static void baselineSmoothing(const float *mag)
+{
+  for (int x = 0; x < BINS; x++) {
+    float avg;
+    if (x > 1 && x < BINS - 2)
+      avg = mag[x] * 0.7 + mag[x - 1] * 0.3 + mag[x - 2] * 0.15 + mag[x + 1] * 0.3 + mag[x + 2] * 0.15;
+    else
+      avg = mag[x];
+    view[x] = 0.7 * 2 * sqrtf(fabsf(avg) * 5) + 0.3 * viewOld[x];
+    viewOld[x] = view[x];
+  }
+}
+
+int main()
+{
+  // Frequency filter against the float FIR
+  for (int seed = 0; seed < 8; seed++) {
+    makeFrame(seed);
+    CHECK(maxError(14, 6, 3) <= 2.0);
+    CHECK(maxError(6, 3, 1) <= 2.0);
+    CHECK(maxError(1, 1, 1) <= 2.0);
+    CHECK(maxError(1, 0, 0) == 0.0);
+  }
+
+  // Unity gain: a flat spectrum is unchanged, edges included
+  for (int i = 0; i < BINS; i++) frame[i] = 60 * 256;
+  setSpectrumSmoothing(14, 6, 3, 0);
+  smoothSpectrum_q15(frame, out, BINS);
+  bool bFlat = true;
+  for (int i = 0; i < BINS; i++) bFlat &= abs(out[i] - 60 * 256) <= 1;
+  CHECK(bFlat);
+
+  // Time filter: out += (fir - out) >> shift, fir from the shift 0 run
+  static int16_t fir[BINS], model[BINS];
+  makeFrame(3);
+  memset(fir, 0, sizeof(fir));
+  setSpectrumSmoothing(14, 6, 3, 0);
+  smoothSpectrum_q15(frame, fir, BINS);
+  memset(out, 0, sizeof(out));
+  memset(model, 0, sizeof(model));
+  setSpectrumSmoothing(14, 6, 3, 2);
+  bool bSame = true;
+  for (int n = 0; n < 5; n++) {
+    smoothSpectrum_q15(frame, out, BINS);
+    for (int i = 0; i < BINS; i++) {
+      model[i] += (fir[i] - model[i]) >> 2;
+      bSame &= out[i] == model[i];
+    }
+  }
+  CHECK(bSame);
+
+  // Bad weights fall back to no frequency filtering
+  makeFrame(5);
+  setSpectrumSmoothing(-1, 2, 2, 0);
+  smoothSpectrum_q15(frame, out, BINS);
+  CHECK(memcmp(out, frame, sizeof(out)) == 0);
+
+  // Time per frame, kernel and the loop it replaced
+  const int runs = 20000;
+  static float mag[BINS];
+  for (int i = 0; i < BINS; i++) mag[i] = powf(10.0, frame[i] / 256.0 / 20.0);
+  setSpectrumSmoothing(14, 6, 3, 1);
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < runs; r++) {
+    frame[r & (BINS - 1)] ^= 1;
+    smoothSpectrum_q15(frame, out, BINS);
+    __asm__ volatile("" : : "r"(out) : "memory");
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int r = 0; r < runs; r++) {
+    mag[r & (BINS - 1)] += 1.0;
+    baselineSmoothing(mag);
+    __asm__ volatile("" : : "r"(view) : "memory");
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  double kernelNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / runs;
+  double baseNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / runs;
+  printf("%d bins: q15 kernel %.0f ns, float loop %.0f ns (host)\n", BINS, kernelNs, baseNs);
+
+  return testResult("test_smoothing");
+}